@@ -12,20 +12,25 @@ in Varyings {
 
 out vec4 frag_color;
 
+// In the std140 layout, the scalars fill the ends of "direction" and "position", but "color", "attenuation" and "coneAngles" are padded to 16 bytes
+// "LightData" in forward-renderer.hpp mirrors this layout (including the padding), so the two must be changed together
 struct Light{
-    int lightType;
     vec3 direction;
+    int lightType;
     vec3 position;
+    float intensity;
     vec3 color;
     vec3 attenuation;
     vec2 coneAngles;
-    float intensity;
-}light;
+};
 
 #define MAX_LIGHTS 100
 
-uniform Light lights[MAX_LIGHTS];
-uniform int lightCount;
+// The lights are uploaded once per frame by the renderer and shared by every lit shader
+layout(std140) uniform Lights {
+    int lightCount;
+    Light lights[MAX_LIGHTS];
+};
 
 uniform struct Material {
     vec3 ambient;  // Ka
@@ -1,10 +1,12 @@
 #include "application.hpp"
+#include "gl-state-tracker.hpp"
 
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <cmath>
 #include <ctime>
 #include <queue>
 #include <tuple>
@@ -17,6 +19,7 @@
 #include <imgui_impl/imgui_impl_glfw.h>
 #include <imgui_impl/imgui_impl_opengl3.h>
 #include "./texture/texture-utils.hpp"
+#include "./memory/frame-allocator.hpp"
 
 #if !defined(NDEBUG)
 // If NDEBUG (no debug) is not defined, enable OpenGL debug messages
@@ -272,6 +275,16 @@ int our::Application::run(int run_for_frames)
     if (currentState)
         currentState->onInitialize();
 
+    // The simulation runs at a fixed tick rate independent of the frame rate
+    if (configs[0].contains("simulation"))
+    {
+        const auto &simulation_config = configs[0]["simulation"];
+        fixedDeltaTime = 1.0 / simulation_config.value("tick-rate", 1.0 / fixedDeltaTime);
+        maxFixedStepsPerFrame = simulation_config.value("max-steps-per-frame", maxFixedStepsPerFrame);
+    }
+    // The time that passed and was not simulated yet
+    double accumulator = 0.0;
+
     // The time at which the last frame started. But there was no frames yet, so we'll just pick the current time.
     double last_frame_time = glfwGetTime();
     int current_frame = 0;
@@ -306,6 +319,21 @@ int our::Application::run(int run_for_frames)
         // Get the current time (the time at which we are starting the current frame).
         double current_frame_time = glfwGetTime();
 
+        // Advance the simulation by as many fixed steps as the elapsed time allows
+        accumulator += current_frame_time - last_frame_time;
+        int fixed_steps = 0;
+        while (accumulator >= fixedDeltaTime && fixed_steps < maxFixedStepsPerFrame)
+        {
+            if (currentState)
+                currentState->onFixedUpdate(fixedDeltaTime);
+            accumulator -= fixedDeltaTime;
+            ++fixed_steps;
+        }
+        // If we could not catch up (e.g. after a long stall), we drop the remaining time instead of simulating it in the next frames
+        if (accumulator >= fixedDeltaTime)
+            accumulator = std::fmod(accumulator, fixedDeltaTime);
+        interpolationAlpha = (float)(accumulator / fixedDeltaTime);
+
         // Call onDraw, in which we will draw the current frame, and send to it the time difference between the last and current frame
         if (currentState)
             currentState->onDraw(current_frame_time - last_frame_time);
@@ -317,6 +345,8 @@ int our::Application::run(int run_for_frames)
         glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 #endif
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // Render the ImGui to the framebuffer
+        // ImGui changes the OpenGL state directly, so the state tracker forgets what it remembers
+        our::GLStateTracker::getInstance()->invalidate();
 
         // Re-enable the debug messages
         glEnable(GL_DEBUG_OUTPUT);
@@ -373,8 +403,15 @@ int our::Application::run(int run_for_frames)
             nextState = nullptr;
             // Initialize the new scene
             currentState->onInitialize();
+            // The time spent loading the new scene should not be simulated
+            accumulator = 0.0;
+            interpolationAlpha = 1.0f;
+            last_frame_time = glfwGetTime();
         }
 
+        // All the scratch data allocated during this frame is released at once
+        our::getFrameArena().reset();
+
         ++current_frame;
     }
 
@@ -3,6 +3,7 @@
 #include <glm/vec2.hpp>
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
+#include "gl-state-tracker.hpp"
 #include <imgui.h>
 
 #include <string>
@@ -40,6 +41,7 @@ namespace our
         virtual std::string getStateName() = 0;
         virtual void onInitialize() {}           // Called once before the game loop.
         virtual void onImmediateGui() {}         // Called every frame to draw the Immediate GUI (if any).
+        virtual void onFixedUpdate(double /*fixedDeltaTime*/) {} // Called zero or more times per frame (before onDraw) to advance the simulation by a fixed time step.
         virtual void onDraw(double deltaTime) {} // Called every frame in the game loop passing the time taken to draw the frame "Delta time".
         virtual void onDestroy() {}              // Called once after the game loop ends for house cleaning.
 
@@ -71,6 +73,10 @@ namespace our
         State *currentState = nullptr; // This will store the current scene that is being run
         State *nextState = nullptr;    // If it is requested to go to another scene, this will contain a pointer to that scene
 
+        double fixedDeltaTime = 1.0 / 60.0; // The time step of the simulation (read from "simulation.tick-rate" in the config)
+        int maxFixedStepsPerFrame = 5;      // The maximum number of simulation steps in a frame, the rest of the time is dropped to avoid a spiral of death
+        float interpolationAlpha = 1.0f;    // How far the current frame is between the last two simulation steps (in the range [0, 1])
+
         // Virtual functions to be overrode and change the default behaviour of the application
         // according to the example needs.
         virtual void configureOpenGL();                       // This function sets OpenGL Window Hints in GLFW.
@@ -184,7 +190,7 @@ namespace our
         {
             GLuint texture_id;
             glGenTextures(1, &texture_id);
-            glBindTexture(GL_TEXTURE_2D, texture_id);
+            our::GLStateTracker::getInstance()->bindTexture2D(texture_id);
 
             // Setup texture parameters
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -195,7 +201,7 @@ namespace our
             // Upload texture data
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
 
-            glBindTexture(GL_TEXTURE_2D, 0);
+            our::GLStateTracker::getInstance()->bindTexture2D(0);
 
             return texture_id;
         }
@@ -229,6 +235,9 @@ namespace our
         [[nodiscard]] const Keyboard &getKeyboard() const { return keyboard; }
         Mouse &getMouse() { return mouse; }
         [[nodiscard]] const Mouse &getMouse() const { return mouse; }
+        [[nodiscard]] double getFixedDeltaTime() const { return fixedDeltaTime; }
+        // The renderer should interpolate between the previous and current simulation states using this factor
+        [[nodiscard]] float getInterpolationAlpha() const { return interpolationAlpha; }
 
         [[nodiscard]] const nlohmann::json &getConfig(unsigned int configNumber = 0) const
         {
@@ -7,6 +7,7 @@
 #include "mesh/mesh.hpp"
 #include "mesh/mesh-utils.hpp"
 #include "material/material.hpp"
+#include "systems/physics/triangle-mesh.hpp"
 #include "deserialize-utils.hpp"
 
 namespace our {
@@ -73,6 +74,22 @@ namespace our {
         }
     };
 
+    // This will load the triangles of the collision meshes defined in "data" and build their hierarchies
+    // data must be in the form:
+    //    { mesh_name : "path/to/3d-model-file", ... }
+    template<>
+    void AssetLoader<TriangleMesh>::deserialize(const nlohmann::json& data) {
+        if(data.is_object()){
+            for(auto& [name, desc] : data.items()){
+                std::string path = desc.get<std::string>();
+                std::vector<glm::vec3> positions;
+                std::vector<unsigned int> elements;
+                if(mesh_utils::loadOBJTriangles(path, positions, elements))
+                    assets[name] = new TriangleMesh(positions, elements);
+            }
+        }
+    };
+
     // This will load all the materials defined in "data"
     // Material deserialization depends on shaders, textures and samplers
     // so you must deserialize these 3 asset types before deserializing materials
@@ -109,6 +126,8 @@ namespace our {
             AssetLoader<Mesh>::deserialize(assetData["meshes"]);
         if(assetData.contains("materials"))
             AssetLoader<Material>::deserialize(assetData["materials"]);
+        if(assetData.contains("collisionMeshes"))
+            AssetLoader<TriangleMesh>::deserialize(assetData["collisionMeshes"]);
     }
 
     void clearAllAssets(){
@@ -117,6 +136,7 @@ namespace our {
         AssetLoader<Sampler>::clear();
         AssetLoader<Mesh>::clear();
         AssetLoader<Material>::clear();
+        AssetLoader<TriangleMesh>::clear();
     }
 
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "camera.hpp"
 #include "../ecs/entity.hpp"
 #include "../components/movement.hpp"
+#include "../systems/physics/physics-queries.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -9,6 +10,9 @@ using glm::vec3, glm::mat4;
 using std::cout;
 namespace our
 {
+    // The follow camera keeps this distance from the walls so that the near plane does not clip through them
+    constexpr float FOLLOW_CAMERA_RADIUS = 0.2f;
+
     vec3 getTransitionComponent(mat4 translationMatrix)
     {
         return vec3(translationMatrix[3][0], translationMatrix[3][1], translationMatrix[3][2]);
@@ -42,7 +46,7 @@ namespace our
     glm::mat4 CameraComponent::getNormalModeViewMatrix()
     {
         auto owner = getOwner();
-        auto M = owner->getLocalToWorldMatrix();
+        auto M = owner->getRenderMatrix(); // The camera follows the interpolated (rendered) transform of its owner
 
         glm::vec3 eye = M * glm::vec4(0., 0., 0., 1.); // as this is a point which is camera center so w = 1
 
@@ -62,7 +66,7 @@ namespace our
     glm::mat4 CameraComponent::getFollowModeViewMatrix()
     {
         auto owner = getOwner();
-        auto M = owner->getLocalToWorldMatrix();
+        auto M = owner->getRenderMatrix(); // The camera follows the interpolated (rendered) transform of its owner
 
         const glm::vec3 lookAtThis = getTransitionComponent(M);
 
@@ -74,6 +78,19 @@ namespace our
             glm::vec3 direction = movementComponent->getMovementDirection(M) * -1.0f;
             cameraLocation = lookAtThis + direction * this->distance;
             cameraLocation.y = this->height;
+
+            // If a wall is between the followed entity and the camera, the camera is pulled in front of it
+            PhysicsQueries *queries = owner->getWorld() ? owner->getWorld()->getPhysicsQueries() : nullptr;
+            glm::vec3 toCamera = cameraLocation - lookAtThis;
+            float length = glm::length(toCamera);
+            QueryHit hit;
+            QueryFilter filter;
+            filter.ignore = owner;
+            filter.tagMask = tagBit(WALL);
+            if (queries != nullptr && length > 0.0f && queries->sphereCast(lookAtThis, FOLLOW_CAMERA_RADIUS, toCamera / length, length, hit, filter))
+            {
+                cameraLocation = lookAtThis + toCamera / length * hit.distance;
+            }
         }
 
         glm::vec3 eye = cameraLocation; // as this is a point which is camera center so w = 1
@@ -10,51 +10,44 @@
 #include "light.hpp"
 #include "movement.hpp"
 
+#include <string>
+#include <unordered_map>
+
 namespace our
 {
 
+    // A component factory creates a component of a certain type in the given entity
+    typedef Component *(*ComponentFactory)(Entity *);
+
+    template <typename T>
+    Component *createComponent(Entity *entity)
+    {
+        return entity->addComponent<T>();
+    }
+
+    // This table maps the "type" string of each component (its ID) to the factory of that component
+    inline const std::unordered_map<std::string, ComponentFactory> componentFactories = {
+        {CameraComponent::getID(), createComponent<CameraComponent>},
+        {FreeCameraControllerComponent::getID(), createComponent<FreeCameraControllerComponent>},
+        {MovementComponent::getID(), createComponent<MovementComponent>},
+        {MeshRendererComponent::getID(), createComponent<MeshRendererComponent>},
+        {RigidBodyComponent::getID(), createComponent<RigidBodyComponent>},
+        {PlayerController::getID(), createComponent<PlayerController>},
+        {BallComponent::getID(), createComponent<BallComponent>},
+        {LightComponent::getID(), createComponent<LightComponent>},
+    };
+
     // Given a json object, this function picks and creates a component in the given entity
     // based on the "type" specified in the json object which is later deserialized from the rest of the json object
     inline void deserializeComponent(const nlohmann::json &data, Entity *entity)
     {
         std::string type = data.value("type", "");
         Component *component = nullptr;
-        // TODO: (Req 8) Add an option to deserialize a "MeshRendererComponent" to the following if-else statement
-        if (type == CameraComponent::getID())
-        {
-            component = entity->addComponent<CameraComponent>();
-        }
-        else if (type == FreeCameraControllerComponent::getID())
-        {
-            component = entity->addComponent<FreeCameraControllerComponent>();
-        }
-        else if (type == MovementComponent::getID())
-        {
-            component = entity->addComponent<MovementComponent>();
-        }
-        else if (type == MeshRendererComponent::getID())
-        {
-            component = entity->addComponent<MeshRendererComponent>();
-        }
-        else if (type == RigidBodyComponent::getID())
-        {
-            component = entity->addComponent<RigidBodyComponent>();
-        }
-        else if (type == PlayerController::getID())
-        {
-            component = entity->addComponent<PlayerController>();
-        }
-        else if (type == BallComponent::getID())
-        {
-            component = entity->addComponent<BallComponent>();
-
-        }
-        else if (type == LightComponent::getID())
+        if (auto it = componentFactories.find(type); it != componentFactories.end())
         {
-            component = entity->addComponent<LightComponent>();
+            component = it->second(entity);
         }
         if (component)
             component->deserialize(data);
-        
     }
 }
\ No newline at end of file
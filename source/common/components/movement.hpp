@@ -3,6 +3,7 @@
 #include "../ecs/entity.hpp"
 #include "../ecs/component.hpp"
 
+#include <cmath>
 #include <glm/glm.hpp>
 #include <iostream>
 #include <glm/gtx/euler_angles.hpp>
@@ -15,6 +16,9 @@
 #define GRAVITY 2.0f
 #define GROUND_LEVEL 1.0f
 
+#define SLEEP_VELOCITY 0.05f // A body slower than this is idle
+#define SLEEP_TICKS 60       // A body that stays idle for this many ticks goes to sleep
+
 using glm::vec3, glm::vec4, glm::mat4;
 
 namespace our
@@ -32,10 +36,10 @@ namespace our
         FIXED_ROTATION
     };
 
-    class MovementComponent : public Component
+    // The runtime state of a movement component
+    // It is kept in a trivially copyable struct so that world snapshots can save and restore it with a memory copy
+    struct MovementState
     {
-
-    public:
         Movement_Type movementType;
 
         glm::mat4 initialTransformation;
@@ -65,6 +69,23 @@ namespace our
         bool stopMovingOneFrame = false;
         glm::vec3 collidedWallNormal = glm::vec3(0.0, 0.0, 0.0);
 
+        // jumping
+        bool ascending = false, descending = false;
+        float vertical_velocity = 0.0f;
+
+        bool boosting = false;
+
+        // sleeping (a sleeping body is skipped by the physics and the movement until something wakes it up)
+        bool sleeping = false;
+        int idleTicks = 0;
+    };
+
+    class MovementComponent : public Component, public MovementState
+    {
+
+    public:
+        typedef MovementState SnapshotState; // The state saved by the world snapshots
+
         // The ID of this component type is "Movement"
         static std::string getID() { return "Movement"; }
 
@@ -89,14 +110,17 @@ namespace our
             return glm::vec3(ownerLocalToWorld[3][0], ownerLocalToWorld[3][1], ownerLocalToWorld[3][2]);
         }
 
+        // A moved body wakes up so that the physics sees where it is now
         void setCurrentPositionInWorld(glm::vec3 position)
         {
             getOwner()->localTransform.position = position;
+            wakeUp();
         }
 
         void setCurrentAngleInWorld(glm::vec3 rotation)
         {
             getOwner()->localTransform.rotation = rotation;
+            wakeUp();
         }
 
         void clampSpeed()
@@ -141,6 +165,35 @@ namespace our
 
         bool isMoving() { return current_velocity > MIN_SPEED_FOR_ROTATION; }
 
+        // Returns true if the body is neither moving nor spinning (bodies moved towards a target and jumping bodies are never idle)
+        bool isIdle() const
+        {
+            return glm::abs(current_velocity) < SLEEP_VELOCITY && glm::length(angular_velocity) < SLEEP_VELOCITY &&
+                   !directedMovementMode && !ascending && !descending && !constant_movement;
+        }
+
+        void wakeUp()
+        {
+            sleeping = false;
+            idleTicks = 0;
+        }
+
+        // Counts the ticks in which the body stayed idle and puts it to sleep after SLEEP_TICKS of them
+        // A body with a velocity (e.g. from the player or from a contact) wakes up
+        void updateSleep()
+        {
+            if (!isIdle())
+            {
+                wakeUp();
+                return;
+            }
+            if (!sleeping && ++idleTicks >= SLEEP_TICKS)
+            {
+                sleeping = true;
+                current_velocity = 0.0f;
+            }
+        }
+
         float getRotationAngle()
         {
             return ROTATION_CONSTANT * current_velocity;
@@ -159,7 +212,7 @@ namespace our
             if (current_velocity == 0 || ascending || descending)
                 return;
 
-            float absSpeed = abs(current_velocity);
+            float absSpeed = std::abs(current_velocity);
 
             int sign = current_velocity > 0 ? 1 : -1;
 
@@ -173,8 +226,6 @@ namespace our
                 roll();
         }
 
-        bool ascending = false, descending = false;
-        float vertical_velocity = 0.0f;
         void jump()
         {
             // if it wasn't grounded last frame then you can't jump
@@ -208,8 +259,7 @@ namespace our
             }
         }
 
-        bool boosting = false;
-        
+
         // Reads linearVelocity & angularVelocity from the given json object
         void deserialize(const nlohmann::json &data) override;
     };
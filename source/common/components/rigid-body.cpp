@@ -1,7 +1,10 @@
 #include "rigid-body.hpp"
+#include "../asset-loader.hpp"
+#include "../systems/physics/triangle-mesh.hpp"
 #include <glm/glm.hpp>
 #include <json/json.hpp>
 #include <string>
+#include <iostream>
 
 namespace our
 {
@@ -46,6 +49,15 @@ namespace our
                 this->wallType = WallType::BACK;
         }
 
+        // A mesh body is bounded by its mesh instead of the given box
+        std::string bodyTypeName = data.value("bodyType", "cube");
+        if (bodyTypeName == "mesh")
+        {
+            mesh = AssetLoader<TriangleMesh>::get(data.value("mesh", ""));
+            if (mesh == nullptr)
+                std::cerr << "Collision mesh \"" << data.value("mesh", "") << "\" was not found, the body will be a box" << std::endl;
+        }
+
         float min_x = (float)data.value("min_x", -1.0);
         float max_x = (float)data.value("max_x", 1.0);
         float min_y = (float)data.value("min_y", -1.0);
@@ -53,6 +65,26 @@ namespace our
         float min_z = (float)data.value("min_z", -1.0);
         float max_z = (float)data.value("max_z", 1.0);
 
+        if (mesh != nullptr)
+        {
+            AABB bounds = mesh->getBounds();
+            min_x = bounds.min.x, min_y = bounds.min.y, min_z = bounds.min.z;
+            max_x = bounds.max.x, max_y = bounds.max.y, max_z = bounds.max.z;
+        }
+
+        min_point = vec3(min_x, min_y, min_z);
+        max_point = vec3(max_x, max_y, max_z);
+
+        // A sphere fills the bounding box by default
+        bodyType = bodyTypeName == "sphere" ? BodyType::SPHERE : mesh != nullptr ? BodyType::MESH : BodyType::CUBE;
+        radius = data.value("radius", glm::max(max_x - min_x, glm::max(max_y - min_y, max_z - min_z)) * 0.5f);
+        continuous = data.value("continuous", false);
+        isStatic = data.value("static", isStatic);
+
+        mass = data.value("mass", mass);
+        restitution = data.value("restitution", restitution);
+        friction = data.value("friction", friction);
+
         boundingBox = {
             // lower square
             vec3(min_x, min_y, min_z),
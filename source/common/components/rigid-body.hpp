@@ -11,10 +11,14 @@ using std::string, std::vector;
 
 namespace our
 {
+    class TriangleMesh;
+
     enum BodyType
     {
         CUBE,
-        SPHERE
+        SPHERE,
+        MESH, // A static triangle mesh (see "TriangleMesh")
+        BODY_TYPE_COUNT
     };
 
     enum Tag
@@ -26,7 +30,8 @@ namespace our
         CAR = 4,
         GOAL = 5,
         OBSTACLE = 6,
-        BOMB = 7
+        BOMB = 7,
+        TAG_COUNT
     };
 
     enum WallType
@@ -44,14 +49,18 @@ namespace our
     {
 
     public:
-        BodyType bodyType;
+        BodyType bodyType = CUBE;
 
         vec3 normal;
 
-        float radius; // for sphere
+        float radius = 1.0f; // for sphere (in the local space of the body, the sphere is centered on the bounding box)
+        const TriangleMesh *mesh = nullptr; // for mesh (owned by the asset loader), the bounding box is the bounds of the mesh
         float mass = 10.0;
         float density = 10.0;
+        float restitution = 0.0f; // How much of the approach speed is kept after a contact (0 stops the body, 1 bounces it back at the same speed)
+        float friction = 0.2f;    // The friction coefficient used by the contact solver
         bool isStatic = false;
+        bool continuous = false; // If true, the motion of the body is swept every tick so that it can not pass through thin walls
 
         vec3 min_point = {-1, -1, -1};
         vec3 max_point = {1, 1, 1};
@@ -68,40 +77,11 @@ namespace our
         RigidBodyComponent() {}
         ~RigidBodyComponent() {}
 
-        vector<vec3> getBoxNormals(glm::mat4 transformation)
-        {
-            vector<vec3> normals;
-
-            // bottom face
-            vec3 edge_1 = boundingBox[1] - boundingBox[0];
-            vec3 edge_2 = boundingBox[3] - boundingBox[0];
-            normals.push_back(glm::normalize(transformation * vec4(glm::cross(edge_1, edge_2), 0.0)));
-
-            // left face
-            edge_1 = boundingBox[4] - boundingBox[0];
-            edge_2 = boundingBox[1] - boundingBox[0];
-            normals.push_back(glm::normalize(transformation * vec4(glm::cross(edge_1, edge_2), 0.0)));
-
-            // front face
-            edge_1 = boundingBox[5] - boundingBox[1];
-            edge_2 = boundingBox[2] - boundingBox[1];
-            normals.push_back(glm::normalize(transformation * vec4(glm::cross(edge_1, edge_2), 0.0)));
-
-            return normals;
-        }
-
-        vector<float> getProjectionRange(vec3 axis, glm::mat4 transformation)
+        // Returns true if the body never moves (walls, ground, goals, meshes and the bodies marked "static" in the level files)
+        // Static bodies are never tested against each other
+        bool isStaticBody() const
         {
-            float min_projection = (float)INT32_MAX;
-            float max_projection = (float)INT32_MIN;
-
-            for (auto &point : boundingBox)
-            {
-                float projection = glm::dot(vec3(transformation * vec4(point, 1.0)), axis);
-                min_projection = std::min(min_projection, projection);
-                max_projection = std::max(max_projection, projection);
-            }
-            return {min_projection, max_projection};
+            return isStatic || bodyType == MESH || tag == WALL || tag == GROUND || tag == GOAL;
         }
 
         vector<vec3> getBoundingBox()
@@ -0,0 +1,47 @@
+#include "command-buffer.hpp"
+#include "world.hpp"
+
+namespace our {
+
+    void CommandBuffer::record(std::function<void(World *)> command) {
+        std::lock_guard<std::mutex> lock(mutex);
+        commands.push_back(std::move(command));
+    }
+
+    void CommandBuffer::add(std::function<void(Entity *)> onCreated) {
+        record([onCreated = std::move(onCreated)](World *world) {
+            Entity *entity = world->add();
+            if (onCreated) onCreated(entity);
+        });
+    }
+
+    void CommandBuffer::markForRemoval(EntityHandle handle) {
+        record([handle](World *world) {
+            if (Entity *entity = world->get(handle))
+                world->markForRemoval(entity);
+        });
+    }
+
+    void CommandBuffer::flush(World *world) {
+        // A command may record more commands, so we keep flushing until the buffer is empty
+        while (true) {
+            std::vector<std::function<void(World *)>> pending;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (commands.empty()) return;
+                pending.swap(commands);
+            }
+            for (auto &command : pending) command(world);
+        }
+    }
+
+    bool CommandBuffer::empty() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return commands.empty();
+    }
+
+    Entity *CommandBuffer::getEntity(World *world, EntityHandle handle) {
+        return world->get(handle);
+    }
+
+}
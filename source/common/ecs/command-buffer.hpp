@@ -0,0 +1,61 @@
+#pragma once
+
+#include "entity.hpp"
+#include "entity-handle.hpp"
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace our {
+
+    class World; // A forward declaration of the World Class
+
+    // A command buffer records structural changes to a world (adding or removing entities and components)
+    // so that they can be applied later at a sync point, when no system is iterating over the world.
+    // It is safe to record commands from multiple threads at the same time.
+    // The commands are applied in the order in which they were recorded when "flush" is called.
+    class CommandBuffer {
+        std::mutex mutex;
+        std::vector<std::function<void(World *)>> commands;
+
+        void record(std::function<void(World *)> command);
+
+    public:
+        // Records the creation of a new entity, "onCreated" is called with the new entity when the buffer is flushed
+        void add(std::function<void(Entity *)> onCreated = nullptr);
+
+        // Records marking the entity for removal (nothing happens if the entity no longer exists)
+        void markForRemoval(EntityHandle handle);
+
+        // Records adding a component of type T to the entity, "onCreated" is called with the new component when the buffer is flushed
+        template <typename T>
+        void addComponent(EntityHandle handle, std::function<void(T *)> onCreated = nullptr) {
+            record([handle, onCreated = std::move(onCreated)](World *world) {
+                if (Entity *entity = getEntity(world, handle)) {
+                    T *component = entity->addComponent<T>();
+                    if (onCreated) onCreated(component);
+                }
+            });
+        }
+
+        // Records deleting the component of type T from the entity
+        template <typename T>
+        void deleteComponent(EntityHandle handle) {
+            record([handle](World *world) {
+                if (Entity *entity = getEntity(world, handle))
+                    entity->deleteComponent<T>();
+            });
+        }
+
+        // Applies all the recorded commands to the world then clears the buffer
+        // This must only be called when no system is running
+        void flush(World *world);
+
+        // Returns true if there are commands waiting to be applied
+        bool empty();
+
+    private:
+        static Entity *getEntity(World *world, EntityHandle handle);
+    };
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "component.hpp"
+#include "component-registry.hpp"
+#include "../memory/arena.hpp"
+#include <array>
+#include <vector>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace our {
+
+    // This is the type-erased interface of a component pool
+    // It allows the entity to return a component to its pool without knowing the component type
+    class ComponentPoolBase {
+    public:
+        // Destroys the given component and gives its memory back to the pool
+        virtual void destroy(Component* component) = 0;
+        virtual ~ComponentPoolBase(){}
+    };
+
+    // A component pool stores all the components of type T that exist in a world.
+    // Components are constructed inside fixed size chunks, so the pool can grow without moving the
+    // components that already exist (entities and systems keep raw pointers to them).
+    // The chunks are allocated from the arena of the world, so their memory is released all at once when the level ends.
+    // The pool also keeps a dense list of the live components so that a system can iterate
+    // over all the components of a certain type without visiting every entity in the world.
+    template<typename T>
+    class ComponentPool : public ComponentPoolBase {
+        static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
+
+        // The number of components stored in a single chunk
+        static constexpr size_t CHUNK_SIZE = 64;
+        using Storage = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+        Arena* arena; // The arena from which the chunks are allocated
+        std::vector<Storage*> chunks; // The memory blocks in which the components are constructed
+        size_t usedInLastChunk = 0; // How many slots of the last chunk were handed out
+        std::vector<void*> freeSlots; // Slots released by destroyed components, these are reused first
+        std::vector<T*> components; // The dense list of the live components
+
+    public:
+        ComponentPool(Arena* arena) : arena(arena) {}
+
+        // Constructs a new component in the pool and returns a pointer to it
+        T* create(){
+            void* memory;
+            if(!freeSlots.empty()){
+                memory = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                if(chunks.empty() || usedInLastChunk == CHUNK_SIZE){
+                    chunks.push_back(arena->allocateArray<Storage>(CHUNK_SIZE));
+                    usedInLastChunk = 0;
+                }
+                memory = &chunks.back()[usedInLastChunk++];
+            }
+            T* component = new (memory) T();
+            component->poolIndex = components.size();
+            components.push_back(component);
+            return component;
+        }
+
+        // Removes the component from the dense list (by swapping it with the last one), then destroys it
+        void destroy(Component* component) override {
+            size_t index = component->poolIndex;
+            T* last = components.back();
+            components[index] = last;
+            last->poolIndex = index;
+            components.pop_back();
+
+            T* typed = static_cast<T*>(component);
+            typed->~T();
+            freeSlots.push_back(typed);
+        }
+
+        // Returns the dense list of all the live components in this pool
+        const std::vector<T*>& getComponents() const { return components; }
+
+        ~ComponentPool() override {
+            for(T* component : components) component->~T();
+        }
+
+        // The pool owns the memory of its components so it should not be copyable
+        ComponentPool(const ComponentPool&) = delete;
+        ComponentPool& operator=(const ComponentPool&) = delete;
+    };
+
+    // This class holds one component pool for every registered component type used in a world
+    // The pools are indexed by the component type ID and created on demand
+    // the first time a component of that type is requested
+    class ComponentStorage {
+        std::array<std::unique_ptr<ComponentPoolBase>, COMPONENT_TYPE_COUNT> pools;
+        Arena* arena; // The arena from which the pools allocate their chunks
+    public:
+        ComponentStorage(Arena* arena) : arena(arena) {}
+
+        // Returns the pool that stores the components of type T
+        template<typename T>
+        ComponentPool<T>& getPool(){
+            auto& pool = pools[componentTypeID<T>()];
+            if(!pool) pool = std::make_unique<ComponentPool<T>>(arena);
+            return *static_cast<ComponentPool<T>*>(pool.get());
+        }
+
+        // Returns the components of type T without creating their pool, so it can be called by systems running in parallel
+        template<typename T>
+        const std::vector<T*>& getComponents() const {
+            static const std::vector<T*> empty;
+            const auto& pool = pools[componentTypeID<T>()];
+            return pool ? static_cast<const ComponentPool<T>*>(pool.get())->getComponents() : empty;
+        }
+
+        // Returns the pool of the given type ID (the pool must already exist)
+        ComponentPoolBase& getPool(size_t typeID){
+            return *pools[typeID];
+        }
+
+        // Deletes all the pools
+        // The memory of their chunks is released when the arena is reset
+        void clear(){
+            for(auto& pool : pools) pool.reset();
+        }
+    };
+
+}
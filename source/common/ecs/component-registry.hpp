@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+namespace our {
+
+    // Forward declarations of all the component types known by the ECS
+    class CameraComponent;
+    class FreeCameraControllerComponent;
+    class MovementComponent;
+    class MeshRendererComponent;
+    class RigidBodyComponent;
+    class PlayerController;
+    class BallComponent;
+    class LightComponent;
+
+    // A compile-time list of component types
+    // The index of a type in this list is its component type ID
+    template<typename... Ts>
+    struct ComponentList {
+        static constexpr size_t count = sizeof...(Ts);
+
+        // Returns the index of T in the list (or count if T is not in the list)
+        template<typename T>
+        static constexpr size_t indexOf(){
+            size_t index = 0;
+            bool found = false;
+            ((found = found || std::is_same<T, Ts>::value, index += found ? 0 : 1), ...);
+            return index;
+        }
+
+        // Calls "function" once for every type in the list passing a null pointer of that type
+        // e.g. forEachType([](auto* tag){ using T = std::remove_pointer_t<decltype(tag)>; ... });
+        template<typename Function>
+        static void forEachType(Function&& function){
+            (function(static_cast<Ts*>(nullptr)), ...);
+        }
+    };
+
+    // This is the registry of all the component types
+    // When you create a new type of components, add it to this list to give it a type ID
+    using RegisteredComponents = ComponentList<
+        CameraComponent,
+        FreeCameraControllerComponent,
+        MovementComponent,
+        MeshRendererComponent,
+        RigidBodyComponent,
+        PlayerController,
+        BallComponent,
+        LightComponent
+    >;
+
+    // The number of registered component types
+    constexpr size_t COMPONENT_TYPE_COUNT = RegisteredComponents::count;
+
+    // The dense type ID of the component type T, it is known at compile time
+    // It is used to index the component slots of an entity and the component pools of a world
+    template<typename T>
+    constexpr size_t componentTypeID(){
+        constexpr size_t id = RegisteredComponents::indexOf<T>();
+        static_assert(id < COMPONENT_TYPE_COUNT, "T must be registered in RegisteredComponents");
+        return id;
+    }
+
+}
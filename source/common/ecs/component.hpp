@@ -6,6 +6,12 @@
 namespace our {
 
     class Entity; // A forward declaration of the Entity Class
+    template<typename T> class ComponentPool; // A forward declaration of the ComponentPool Class
+
+    // A component type can opt in to world snapshots (see "World::snapshot") by keeping its runtime state
+    // in a trivially copyable struct that it inherits from and naming it "SnapshotState", e.g.:
+    //     class MovementComponent : public Component, public MovementState { public: typedef MovementState SnapshotState; ... };
+    // The snapshot then saves and restores that struct with a plain memory copy.
 
     // A component is a data container that can be added to an entity.
     // The role of the entity in the world is defined by the components it holds.
@@ -14,9 +20,11 @@ namespace our {
     class Component {
         Entity* owner; // A pointer to the entity that owns this component
         friend Entity; // The entity is a friend since it is the only one allowed to set itself as an owner of a certain component.
+        size_t poolIndex = 0; // The index of this component in the dense list of its pool
+        template<typename T> friend class ComponentPool; // The pool is a friend since it is the only one allowed to place the component in its memory
     public:
         // This static method returns a unique string that identifies each type of components
-        // This ID will be used as the key to store a component into the entity's component map 
+        // This ID is used as the key of the component in the json files and the component factory
         // When you create a new type of components, override this function to return a new unique ID
         static std::string getID() { return "Component"; }
         // Reads the data of the component from a json object
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+namespace our {
+
+    // A handle is a safe reference to an entity in a world
+    // It holds the index of the entity slot and the generation of the slot when the entity was created.
+    // Whenever an entity is deleted, the generation of its slot is incremented, so the handles to the deleted
+    // entity become stale even after the slot is reused by another entity.
+    // Use "World::get" to get the entity of a handle (it returns null if the entity no longer exists).
+    struct EntityHandle {
+        static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+        uint32_t index = INVALID_INDEX; // The index of the entity slot in the world
+        uint32_t generation = 0; // The generation of the slot when the entity was created
+
+        // Returns true if the handle was never assigned to an entity
+        bool isNull() const { return index == INVALID_INDEX; }
+
+        bool operator==(const EntityHandle& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const EntityHandle& other) const { return !(*this == other); }
+    };
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "entity.hpp"
+#include "entity-handle.hpp"
+#include "../memory/arena.hpp"
+#include <vector>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace our {
+
+    // The entity storage is a slot map that holds all the entities of a world.
+    // Entities are constructed inside fixed size chunks, so their addresses never change while they are alive
+    // and the raw pointers held by the components and the children stay valid.
+    // The slots of deleted entities are recycled, and each slot has a generation that is incremented
+    // whenever its entity is deleted, so a stale handle can be detected with a single comparison.
+    // The storage also keeps a dense list of the live entities to iterate over them without visiting empty slots.
+    // The chunks are allocated from the arena of the world, so their memory is released all at once when the level ends.
+    class EntityStorage {
+        // The number of entities stored in a single chunk
+        static constexpr size_t CHUNK_SIZE = 256;
+        using Storage = std::aligned_storage_t<sizeof(Entity), alignof(Entity)>;
+
+        struct Slot {
+            uint32_t generation = 0; // Incremented every time the entity in this slot is deleted
+            uint32_t denseIndex = 0; // The index of the entity in the dense list (only meaningful if alive)
+            bool alive = false; // Whether the slot currently holds an entity
+        };
+
+        Arena* arena; // The arena from which the chunks are allocated
+        std::vector<Storage*> chunks; // The memory blocks in which the entities are constructed
+        std::vector<Slot> slots; // The book-keeping data of every slot handed out so far
+        std::vector<uint32_t> freeSlots; // The indices of the slots released by deleted entities, these are reused first
+        std::vector<Entity*> entities; // The dense list of the live entities
+
+        Entity* getSlotEntity(uint32_t index) const {
+            return reinterpret_cast<Entity*>(&chunks[index / CHUNK_SIZE][index % CHUNK_SIZE]);
+        }
+
+    public:
+        EntityStorage(Arena* arena) : arena(arena) {}
+
+        // Constructs a new entity in a free slot and returns a pointer to it
+        Entity* create(){
+            uint32_t index;
+            if(!freeSlots.empty()){
+                index = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                index = (uint32_t)slots.size();
+                slots.emplace_back();
+            }
+            // The chunks are dropped when the arena memory is released, so we may need to allocate the chunk of a reused slot
+            while(chunks.size() <= index / CHUNK_SIZE) chunks.push_back(arena->allocateArray<Storage>(CHUNK_SIZE));
+            Slot& slot = slots[index];
+            slot.alive = true;
+            slot.denseIndex = (uint32_t)entities.size();
+
+            Entity* entity = new (getSlotEntity(index)) Entity();
+            entity->handle = {index, slot.generation};
+            entities.push_back(entity);
+            return entity;
+        }
+
+        // Destroys the entity, removes it from the dense list (by swapping it with the last one)
+        // and invalidates all the handles that refer to it
+        void destroy(Entity* entity){
+            uint32_t index = entity->handle.index;
+            Slot& slot = slots[index];
+
+            Entity* last = entities.back();
+            entities[slot.denseIndex] = last;
+            slots[last->handle.index].denseIndex = slot.denseIndex;
+            entities.pop_back();
+
+            entity->~Entity();
+            slot.alive = false;
+            slot.generation++;
+            freeSlots.push_back(index);
+        }
+
+        // Returns the entity referred to by the handle, or null if the handle is stale
+        Entity* get(EntityHandle handle) const {
+            return isAlive(handle) ? getSlotEntity(handle.index) : nullptr;
+        }
+
+        // Returns true if the handle refers to an entity that is still alive
+        bool isAlive(EntityHandle handle) const {
+            return handle.index < slots.size() && slots[handle.index].alive && slots[handle.index].generation == handle.generation;
+        }
+
+        // Returns true if the given pointer is a live entity of this storage
+        bool contains(const Entity* entity) const {
+            return entity != nullptr && get(entity->handle) == entity;
+        }
+
+        // Returns the dense list of the live entities
+        const std::vector<Entity*>& getEntities() const { return entities; }
+
+        // Destroys all the live entities
+        // The slots are kept (with their generations incremented) so that they can be reused
+        void clear(){
+            while(!entities.empty()) destroy(entities.back());
+        }
+
+        // Destroys all the live entities and forgets the chunks (their memory is about to be released with the arena)
+        // The generations of the slots are kept, so the handles of the deleted entities remain stale
+        void releaseMemory(){
+            clear();
+            chunks.clear();
+            // Hand out the lowest indices first so that the chunks are allocated again in order
+            freeSlots.clear();
+            for(size_t index = slots.size(); index > 0; index--) freeSlots.push_back((uint32_t)(index - 1));
+        }
+
+        ~EntityStorage(){
+            clear();
+        }
+
+        // The storage owns the memory of its entities so it should not be copyable
+        EntityStorage(const EntityStorage&) = delete;
+        EntityStorage& operator=(const EntityStorage&) = delete;
+    };
+
+}
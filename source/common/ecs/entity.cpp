@@ -1,4 +1,5 @@
 #include "entity.hpp"
+#include "world.hpp"
 #include "../deserialize-utils.hpp"
 #include "../components/component-deserializer.hpp"
 
@@ -10,24 +11,90 @@ namespace our {
     // Remember that you can get the transformation matrix from this entity to its parent from "localTransform"
     // To get the local to world matrix, you need to combine this entities matrix with its parent's matrix and
     // its parent's parent's matrix and so on till you reach the root.
-    glm::mat4 Entity::getLocalToWorldMatrix() const {
-        const Entity* currentNode = this;
-        glm::mat4 TransformationMatrix = glm::mat4(1.);
-        while(currentNode != nullptr)
-        {
-            TransformationMatrix = currentNode->localTransform.toMat4() * TransformationMatrix;
-            currentNode = currentNode->parent;
+    // The matrix is cached, so we first make sure that the caches of the ancestors are up to date, then we update ours.
+    const glm::mat4& Entity::getLocalToWorldMatrix() const {
+        if(parent != nullptr) parent->getLocalToWorldMatrix();
+        updateWorldTransform();
+        return worldTransform.localToWorld;
+    }
+
+    const glm::mat4& Entity::getLocalToWorldInverseTranspose() const {
+        getLocalToWorldMatrix();
+        if(!worldTransform.inverseTransposeValid){
+            worldTransform.localToWorldInverseTranspose = glm::transpose(glm::inverse(worldTransform.localToWorld));
+            worldTransform.inverseTransposeValid = true;
         }
+        return worldTransform.localToWorldInverseTranspose;
+    }
+
+    bool Entity::updateWorldTransform() const {
+        WorldTransformCache& cache = worldTransform;
+        bool dirty = !cache.valid ||
+            cache.local != localTransform ||
+            cache.parent != (parent != nullptr ? parent->handle : EntityHandle()) ||
+            (parent != nullptr && cache.parentVersion != parent->worldTransform.version);
+        if(!dirty) return false;
 
-        return TransformationMatrix;
+        cache.local = localTransform;
+        cache.parent = parent != nullptr ? parent->handle : EntityHandle();
+        if(parent != nullptr){
+            cache.parentVersion = parent->worldTransform.version;
+            cache.localToWorld = parent->worldTransform.localToWorld * localTransform.toMat4();
+        } else {
+            cache.localToWorld = localTransform.toMat4();
+        }
+        cache.version++;
+        cache.valid = true;
+        cache.inverseTransposeValid = false;
+        return true;
+    }
+
+    bool Entity::updateRenderTransform(float interpolationAlpha) const {
+        WorldTransformCache& cache = worldTransform;
+        const Transform& previous = cache.previous;
+        bool moved = cache.hasPrevious && interpolationAlpha < 1.0f && previous != localTransform;
+        bool parentInterpolated = parent != nullptr && parent->worldTransform.renderInterpolated;
+        if(!moved && !parentInterpolated){
+            cache.renderInterpolated = false;
+            return false;
+        }
+
+        glm::mat4 local;
+        if(moved){
+            Transform interpolated;
+            interpolated.position = glm::mix(previous.position, localTransform.position, interpolationAlpha);
+            if(localTransform.useQuaternion)
+                interpolated.setOrientation(glm::slerp(previous.getOrientation(), localTransform.getOrientation(), interpolationAlpha));
+            else
+                interpolated.rotation = glm::mix(previous.rotation, localTransform.rotation, interpolationAlpha);
+            interpolated.scale = glm::mix(previous.scale, localTransform.scale, interpolationAlpha);
+            local = interpolated.toMat4();
+        } else {
+            local = localTransform.toMat4();
+        }
+        cache.renderLocalToWorld = parent != nullptr ? parent->getRenderMatrix() * local : local;
+        cache.renderInterpolated = true;
+        return true;
+    }
+
+    const glm::mat4& Entity::getRenderMatrix() const {
+        if(worldTransform.renderInterpolated) return worldTransform.renderLocalToWorld;
+        return getLocalToWorldMatrix();
+    }
+
+    glm::mat4 Entity::getRenderInverseTranspose() const {
+        if(worldTransform.renderInterpolated) return glm::transpose(glm::inverse(worldTransform.renderLocalToWorld));
+        return getLocalToWorldInverseTranspose();
     }
 
     glm::vec3 Entity::getLocalToWorldCenter() const {
-        glm::mat4 matrix =  getLocalToWorldMatrix();
+        const glm::mat4& matrix = getLocalToWorldMatrix();
         return glm::vec3(matrix[3][0],matrix[3][1],matrix[3][2]);
     }
 
-    
+    void Entity::notifyComponentsChanged(const ComponentMask& previousMask) {
+        world->updateViews(this, previousMask);
+    }
 
     // Deserializes the entity data and components from a json object
     void Entity::deserialize(const nlohmann::json& data){
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "component.hpp"
+#include "component-pool.hpp"
+#include "entity-handle.hpp"
 #include "transform.hpp"
-#include <list>
-#include <iterator>
+#include <array>
+#include <bitset>
 #include <string>
 #include <glm/glm.hpp>
 
@@ -15,127 +17,163 @@ namespace our {
 
     class World; // A forward declaration of the World Class
 
+    // A bit mask with one bit for each registered component type
+    typedef std::bitset<COMPONENT_TYPE_COUNT> ComponentMask;
+
     class Entity{
         World *world; // This defines what world own this entity
-        std::list<Component*> components; // A list of components that are owned by this entity
+        ComponentStorage *storage; // The component pools of the world, the components of this entity are allocated from them
+        std::array<Component*, COMPONENT_TYPE_COUNT> components{}; // The components owned by this entity indexed by their type ID
+        ComponentMask componentMask; // The bit of each component type is set if this entity has a component of that type
+        EntityHandle handle; // The handle of this entity in its world
 
         friend World; // The world is a friend since it is the only class that is allowed to instantiate an entity
+        friend class EntityStorage; // The entity storage is a friend since it constructs the entities in its slots
         Entity() = default; // The entity constructor is private since only the world is allowed to instantiate an entity
-    
-        template<typename T>
-        bool canBeCasted(Component* tester)
-        {
-            bool isCastableOfTypeT = dynamic_cast<T*>(tester) != nullptr;
-            return isCastableOfTypeT;
-        }
 
-        void deleteComponentFromVector(Component* component)
+        // The world transform of the entity is cached since it is requested many times per frame.
+        // The cache remembers the local transform and the parent state it was computed from,
+        // so it is only recomputed when the entity or one of its ancestors actually changed.
+        struct WorldTransformCache {
+            Transform local; // The local transform from which the cache was computed
+            EntityHandle parent; // The parent at the time the cache was computed (a handle, since a new entity may reuse the parent's memory)
+            uint32_t parentVersion = 0; // The version of the parent cache at the time the cache was computed
+            uint32_t version = 0; // Incremented every time the world matrix changes so the children know they are dirty
+            bool valid = false;
+            bool inverseTransposeValid = false;
+            glm::mat4 localToWorld = glm::mat4(1.0f);
+            glm::mat4 localToWorldInverseTranspose = glm::mat4(1.0f);
+
+            // The local transform at the previous simulation step, used to interpolate the rendered transform between steps
+            Transform previous;
+            bool hasPrevious = false;
+            // The interpolated local to world matrix, only meaningful if "renderInterpolated" is true
+            // (otherwise, the entity and its ancestors did not move in the last step and "localToWorld" is used)
+            bool renderInterpolated = false;
+            glm::mat4 renderLocalToWorld = glm::mat4(1.0f);
+        };
+        mutable WorldTransformCache worldTransform;
+
+        // Tells the world that the component mask of this entity changed so it can update its cached views
+        void notifyComponentsChanged(const ComponentMask& previousMask);
+
+        // Returns the component in the given slot to its pool and clears the slot
+        void deleteComponentInSlot(size_t typeID, bool notifyWorld = true)
         {
-            this->components.remove(component);
-            delete component;
+            ComponentMask previousMask = componentMask;
+            Component* component = components[typeID];
+            components[typeID] = nullptr;
+            componentMask.reset(typeID);
+            storage->getPool(typeID).destroy(component);
+            if(notifyWorld) notifyComponentsChanged(previousMask);
         }
     public:
         std::string name; // The name of the entity. It could be useful to refer to an entity by its name
-        Entity* parent;   // The parent of the entity. The transform of the entity is relative to its parent.
+        Entity* parent = nullptr; // The parent of the entity. The transform of the entity is relative to its parent.
                           // If parent is null, the entity is a root entity (has no parent).
         Transform localTransform; // The transform of this entity relative to its parent.
 
         World* getWorld() const { return world; } // Returns the world to which this entity belongs
-
-        glm::mat4 getLocalToWorldMatrix() const; // Computes and returns the transformation from the entities local space to the world space
-        glm::vec3 getLocalToWorldCenter() const; // Computes and returns the transformation from the entities local space to the world space
+        EntityHandle getHandle() const { return handle; } // Returns a handle that can be kept to refer to this entity safely
+
+        const glm::mat4& getLocalToWorldMatrix() const; // Returns the (cached) transformation from the entities local space to the world space
+        const glm::mat4& getLocalToWorldInverseTranspose() const; // Returns the (cached) inverse transpose of the local to world matrix (used to transform normals)
+        glm::vec3 getLocalToWorldCenter() const; // Returns the position of the entity origin in the world space
+        // Recomputes the cached world transform if this entity changed, assuming that the parent cache is already up to date
+        // Returns true if the world matrix was recomputed
+        bool updateWorldTransform() const;
+
+        // Remembers the current local transform as the state of the previous simulation step (called before every simulation step)
+        void savePreviousTransform() { worldTransform.previous = localTransform; worldTransform.hasPrevious = true; }
+        // Computes the matrix used for rendering by interpolating between the previous and the current simulation steps
+        // assuming that the parent render matrix is already up to date. Returns true if the result differs from the world matrix
+        bool updateRenderTransform(float interpolationAlpha) const;
+        // Returns the (interpolated) local to world matrix that should be used for rendering
+        const glm::mat4& getRenderMatrix() const;
+        // Returns the inverse transpose of the render matrix (used to transform normals)
+        glm::mat4 getRenderInverseTranspose() const;
         void deserialize(const nlohmann::json&); // Deserializes the entity data and components from a json object
+
+        // Returns the mask of the component types held by this entity
+        const ComponentMask& getComponentMask() const { return componentMask; }
         
-        // This template method create a component of type T,
-        // adds it to the components map and returns a pointer to it 
+        // This template method create a component of type T in the world's pool of T,
+        // puts it in the slot of T and returns a pointer to it
+        // An entity holds at most one component of each type, so any previous component of type T is deleted
         template<typename T>
         T* addComponent(){
             static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
-            
-            T* component = new T;
+            constexpr size_t typeID = componentTypeID<T>();
+            if(components[typeID]) deleteComponentInSlot(typeID);
+
+            T* component = storage->getPool<T>().create();
             component->owner = this;
-            this->components.push_back(component);
+            components[typeID] = component;
+            ComponentMask previousMask = componentMask;
+            componentMask.set(typeID);
+            notifyComponentsChanged(previousMask);
             
             return component;
         }
 
-        // This template method searhes for a component of type T and returns a pointer to it
+        // This template method returns true if the entity has a component of type T
+        template<typename T>
+        bool hasComponent() const {
+            return componentMask.test(componentTypeID<T>());
+        }
+
+        // This template method returns a pointer to the component of type T
         // If no component of type T was found, it returns a nullptr 
         template<typename T>
         T* getComponent(){
-            
-            //TODO: (Req 8) Go through the components list and find the first component that can be dynamically cast to "T*".
-            // Return the component you found, or return null of nothing was found.
-            for (auto& component_i : this->components)
-            {
-                if (canBeCasted<T>(component_i)) 
-                {
-                    return dynamic_cast<T*>(component_i);
-                }
-            }
-            return nullptr;
+            return static_cast<T*>(components[componentTypeID<T>()]);
         }
 
-        // This template method dynami and returns a pointer to it
-        // If no component of type T was found, it returns a nullptr 
+        // This template method returns the component at the given index (components are ordered by their type IDs)
+        // If the index is out of range or the component is not of type T, it returns a nullptr 
         template<typename T>
         T* getComponent(size_t index){
-            auto it = components.begin();
-            std::advance(it, index);
-            if(it != components.end())
-                return dynamic_cast<T*>(*it);
+            for(Component* component : components){
+                if(component && index-- == 0)
+                    return dynamic_cast<T*>(component);
+            }
             return nullptr;
         }
 
         // This template method searhes for a component of type T and deletes it
         template<typename T>
         void deleteComponent(){
-            //TODO: (Req 8) Go through the components list and find the first component that can be dynamically cast to "T*".
-            // If found, delete the found component and remove it from the components list
-            for (auto& component : components)
-            {
-                if (canBeCasted<T>(component))
-                {
-                    deleteComponentFromVector(component);
-                    return;
-                }
-            }
+            constexpr size_t typeID = componentTypeID<T>();
+            if(components[typeID]) deleteComponentInSlot(typeID);
         }
 
-        // This template method searhes for a component of type T and deletes it
+        // This method deletes the component at the given index (components are ordered by their type IDs)
         void deleteComponent(size_t index){
-            auto it = components.begin();
-            std::advance(it, index);
-            if(it != components.end()) {
-                delete *it;
-                components.erase(it);
+            for(size_t typeID = 0; typeID < COMPONENT_TYPE_COUNT; typeID++){
+                if(components[typeID] && index-- == 0){
+                    deleteComponentInSlot(typeID);
+                    return;
+                }
             }
         }
 
         // This template method searhes for the given component and deletes it
         template<typename T>
         void deleteComponent(T const* component){
-            //TODO: (Req 8) Go through the components list and find the given component "component".
-            // If found, delete the found component and remove it from the components list
-            for (auto component_i : components)
-            {
-                if (component_i == component) 
-                {
-                    deleteComponentFromVector(component_i);
+            for(size_t typeID = 0; typeID < COMPONENT_TYPE_COUNT; typeID++){
+                if(components[typeID] && components[typeID] == component){
+                    deleteComponentInSlot(typeID);
                     return;
                 }
             }
         }
 
         // Since the entity owns its components, they should be deleted alongside the entity
+        // The world removes the entity from its views before deleting it, so there is no need to notify it
         ~Entity(){
-            //TODO: (Req 8) Delete all the components in "components".
-            
-            for (auto component : components)
-            {
-                delete component;
+            for(size_t typeID = 0; typeID < COMPONENT_TYPE_COUNT; typeID++){
+                if(components[typeID]) deleteComponentInSlot(typeID, false);
             }
-            components.clear();
         }
 
         // Entities should not be copyable
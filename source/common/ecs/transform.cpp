@@ -17,31 +17,80 @@ namespace our
     {
         // TODO: (Req 3) Write this function
 
-        glm::mat4 identityMatrix = glm::mat4(1.0);
+        // Equivalent to translation * rotation * scaling, using the cached rotation matrix
+        glm::mat4 answer = glm::mat4(getRotationMatrix());
+        answer[0] *= scale.x;
+        answer[1] *= scale.y;
+        answer[2] *= scale.z;
+        answer[3] = glm::vec4(position, 1.0f);
 
-        glm::mat4 scalingMatrix = glm::scale(identityMatrix, this->scale);
+        return answer;
+    }
+
+    const glm::mat3 &Transform::getRotationMatrix() const
+    {
+        if (rotation != matrixRotation)
+        {
+            rotationMatrix = glm::mat3(glm::yawPitchRoll(rotation.y, rotation.x, rotation.z));
+            matrixRotation = rotation;
+        }
+        return rotationMatrix;
+    }
 
-        glm::mat4 rotationMatrix = glm::yawPitchRoll(rotation.y, rotation.x, rotation.z);
+    glm::quat Transform::getOrientation() const
+    {
+        // The euler angles may have been set directly since the orientation was last updated
+        if (rotation == orientationRotation)
+            return orientation;
+        return glm::normalize(glm::quat_cast(getRotationMatrix()));
+    }
 
-        glm::mat4 translationMatrix = glm::translate(identityMatrix, this->position);
+    void Transform::setOrientation(const glm::quat &newOrientation)
+    {
+        // "rotation" is left as it is, so the cached matrix stays valid until the euler angles are set directly
+        orientation = glm::normalize(newOrientation);
+        rotationMatrix = glm::mat3_cast(orientation);
+        matrixRotation = orientationRotation = rotation;
+        eulerAnglesStale = true;
+    }
 
-        glm::mat4 answer = translationMatrix * rotationMatrix * scalingMatrix;
+    const glm::vec3 &Transform::getEulerAngles()
+    {
+        if (eulerAnglesStale && rotation == orientationRotation)
+        {
+            glm::extractEulerAngleYXZ(glm::mat4(rotationMatrix), rotation.y, rotation.x, rotation.z);
+            matrixRotation = orientationRotation = rotation;
+        }
+        eulerAnglesStale = false;
+        return rotation;
+    }
 
-        return answer;
+    void Transform::rotate(glm::vec3 angles)
+    {
+        if (!useQuaternion)
+        {
+            rotation += angles;
+            return;
+        }
+        // The rotations of a tick are small, so the first order quaternion of the angles is used
+        // Neither this nor "setOrientation" calls a trigonometric function
+        glm::quat delta = glm::normalize(glm::quat(1.0f, angles.x * 0.5f, angles.y * 0.5f, angles.z * 0.5f));
+        setOrientation(getOrientation() * delta);
     }
 
     glm::vec3 Transform::convertToLocalSpace(glm::vec3 vector)
     {
-        glm::mat4 rotationMatrix = glm::yawPitchRoll(rotation.y, rotation.x, rotation.z);
-        glm::vec3 rotatedVector = rotationMatrix * glm::vec4(vector, 0.0f);
+        return getRotationMatrix() * vector;
+    }
 
-        return rotatedVector;
+    bool Transform::operator==(const Transform &other) const
+    {
+        return position == other.position && rotation == other.rotation && orientation == other.orientation && scale == other.scale;
     }
 
     void Transform::applyLinearVelocity(glm::vec3 forward, float velocity)
     {
-        glm::mat4 rotationMatrix = glm::yawPitchRoll(rotation.y, rotation.x, rotation.z);
-        glm::vec3 rotatedForward = rotationMatrix * glm::vec4(forward, 0.0f);
+        glm::vec3 rotatedForward = getRotationMatrix() * forward;
 
         position += rotatedForward * velocity;
         position.y = std::max(position.y, 1.0f); // 1.0f is the ground level and
@@ -55,9 +104,9 @@ namespace our
         position += direction * velocity;
     }
 
-    void Transform::applyAngularVelocity(glm::vec3 velocity)
+    void Transform::applyAngularVelocity(glm::vec3 velocity, float deltaTime)
     {
-        rotation += glm::radians(velocity);
+        rotate(glm::radians(velocity) * deltaTime);
     }
 
     // Deserializes the entity data and components from a json object
@@ -66,10 +115,8 @@ namespace our
         position = data.value("position", position);
         rotation = glm::radians(data.value("rotation", glm::degrees(rotation)));
         scale = data.value("scale", scale);
-
-        initialPositionNew = position;
-        initialRotationNew = rotation;
-        initialScaleNew = scale;
+        // The orientation is always read as euler angles (in degrees)
+        useQuaternion = data.value("useQuaternion", useQuaternion);
     }
 
 }
\ No newline at end of file
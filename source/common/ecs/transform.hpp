@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <json/json.hpp>
 
 namespace our
@@ -14,20 +15,44 @@ namespace our
         glm::vec3 rotation = glm::vec3(0, 0, 0); // The rotation is defined using euler angles (y: yaw, x: pitch, z: roll). (0,0,0) means no rotation
         glm::vec3 scale = glm::vec3(1, 1, 1);    // The scale is defined as a vec3. (1,1,1) means no scaling.
 
-        glm::vec3 initialPositionNew = glm::vec3(0, 0, 0); // The position is defined as a vec3. (0,0,0) means no translation
-        glm::vec3 initialRotationNew = glm::vec3(0, 0, 0); // The rotation is defined using euler angles (y: yaw, x: pitch, z: roll). (0,0,0) means no rotation
-        glm::vec3 initialScaleNew = glm::vec3(1, 1, 1);    // The scale is defined as a vec3. (1,1,1) means no scaling.
+        // If true, rotations are applied to a quaternion (around the local axes), so the object can turn in any direction without gimbal lock.
+        // The quaternion is then the source of truth and "rotation" is only brought up to date by "getEulerAngles".
+        // The euler angles can still be set directly, and the orientation is then derived from them.
+        bool useQuaternion = false;
 
         // This function computes and returns a matrix that represents this transform
         glm::mat4 toMat4() const;
 
+        // Returns the rotation matrix of the euler angles, it is cached and only recomputed when the angles change
+        const glm::mat3 &getRotationMatrix() const;
+        glm::quat getOrientation() const;
+        // Sets the orientation and its rotation matrix, the euler angles are only extracted when they are requested
+        void setOrientation(const glm::quat &orientation);
+        // Returns the euler angles, after extracting them from the orientation if it was set since they were last requested
+        const glm::vec3 &getEulerAngles();
+        // Rotates by the given angles (in radians): they are added to the euler angles,
+        // or applied around the local axes in quaternion mode
+        void rotate(glm::vec3 angles);
+
         void applyLinearVelocity(glm::vec3 forward, float velocity);
         void moveTowards(glm::vec3 destination, glm::vec3 source, float velocity);
-        void applyAngularVelocity(glm::vec3 velocity);
+        void applyAngularVelocity(glm::vec3 velocity, float deltaTime); // The angular velocity is in degrees per second
 
         glm::vec3 convertToLocalSpace(glm::vec3 vector);
+
+        // Two transforms are equal if they have the same position, euler angles, orientation and scale (no matrix is computed)
+        bool operator==(const Transform &other) const;
+        bool operator!=(const Transform &other) const { return !(*this == other); }
+
         // Deserializes the entity data and components from a json object
         void deserialize(const nlohmann::json &);
+
+    private:
+        mutable glm::mat3 rotationMatrix = glm::mat3(1.0f);
+        mutable glm::vec3 matrixRotation = glm::vec3(0, 0, 0); // The euler angles from which the rotation matrix was computed
+        glm::quat orientation = glm::quat(1, 0, 0, 0);
+        glm::vec3 orientationRotation = glm::vec3(0, 0, 0); // The value of "rotation" when the orientation was set
+        bool eulerAnglesStale = false; // True if the orientation was set after "rotation" was last extracted from it
     };
 
-}
\ No newline at end of file
+}
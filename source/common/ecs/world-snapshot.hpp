@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace our {
+
+    // A snapshot holds the state of the entities of a world at some moment in a single contiguous binary blob
+    // It contains the local transform of every entity and the "SnapshotState" of every component type that opted in.
+    // It is created by "World::snapshot" and applied back by "World::restore".
+    // NOTE: A snapshot does not create or delete entities, it only restores the state of the entities that still exist.
+    class WorldSnapshot {
+        std::vector<std::byte> data;
+        friend class World;
+    public:
+        // Returns true if the snapshot holds no data
+        bool empty() const { return data.empty(); }
+        // Returns the size of the snapshot in bytes
+        size_t size() const { return data.size(); }
+    };
+
+}
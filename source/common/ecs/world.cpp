@@ -1,4 +1,8 @@
 #include "world.hpp"
+#include "../components/component-deserializer.hpp"
+
+#include <cstring>
+#include <type_traits>
 
 
 namespace our {
@@ -22,4 +26,90 @@ namespace our {
         }
     }
 
-}
\ No newline at end of file
+    // A component type supports snapshots if it defines the type "SnapshotState"
+    template<typename T, typename = void>
+    struct HasSnapshotState : std::false_type {};
+    template<typename T>
+    struct HasSnapshotState<T, std::void_t<typename T::SnapshotState>> : std::true_type {};
+
+    template<typename T>
+    static void writeBytes(std::vector<std::byte>& data, const T& value){
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable data can be written to a snapshot");
+        size_t offset = data.size();
+        data.resize(offset + sizeof(T));
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+
+    template<typename T>
+    static void readBytes(const std::byte*& cursor, T& value){
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+    }
+
+    // The snapshot layout is:
+    //  - the number of entities, then for every entity: its handle followed by its local transform
+    //  - for every component type that supports snapshots (in the registry order):
+    //    the number of components, then for every component: the handle of its owner followed by its state
+    WorldSnapshot World::snapshot(){
+        WorldSnapshot snapshot;
+        std::vector<std::byte>& data = snapshot.data;
+
+        const auto& allEntities = entities.getEntities();
+        data.reserve(sizeof(uint32_t) + allEntities.size() * (sizeof(EntityHandle) + sizeof(Transform)));
+        writeBytes(data, (uint32_t)allEntities.size());
+        for(Entity* entity : allEntities){
+            writeBytes(data, entity->getHandle());
+            writeBytes(data, entity->localTransform);
+        }
+
+        RegisteredComponents::forEachType([&](auto* tag){
+            using T = std::remove_pointer_t<decltype(tag)>;
+            if constexpr (HasSnapshotState<T>::value) {
+                using State = typename T::SnapshotState;
+                const auto& components = componentStorage.getPool<T>().getComponents();
+                writeBytes(data, (uint32_t)components.size());
+                for(T* component : components){
+                    writeBytes(data, component->getOwner()->getHandle());
+                    writeBytes(data, static_cast<const State&>(*component));
+                }
+            }
+        });
+        return snapshot;
+    }
+
+    void World::restore(const WorldSnapshot& snapshot){
+        if(snapshot.empty()) return;
+        const std::byte* cursor = snapshot.data.data();
+
+        uint32_t entityCount;
+        readBytes(cursor, entityCount);
+        for(uint32_t index = 0; index < entityCount; index++){
+            EntityHandle handle;
+            readBytes(cursor, handle);
+            if(Entity* entity = entities.get(handle)){
+                readBytes(cursor, entity->localTransform);
+                entity->savePreviousTransform();
+            } else {
+                cursor += sizeof(Transform);
+            }
+        }
+
+        RegisteredComponents::forEachType([&](auto* tag){
+            using T = std::remove_pointer_t<decltype(tag)>;
+            if constexpr (HasSnapshotState<T>::value) {
+                using State = typename T::SnapshotState;
+                uint32_t componentCount;
+                readBytes(cursor, componentCount);
+                for(uint32_t index = 0; index < componentCount; index++){
+                    EntityHandle handle;
+                    readBytes(cursor, handle);
+                    Entity* entity = entities.get(handle);
+                    T* component = entity ? entity->getComponent<T>() : nullptr;
+                    if(component) readBytes(cursor, static_cast<State&>(*component));
+                    else cursor += sizeof(State);
+                }
+            }
+        });
+    }
+
+}
@@ -1,7 +1,15 @@
 #pragma once
 
 #include <unordered_set>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include "entity.hpp"
+#include "entity-storage.hpp"
+#include "command-buffer.hpp"
+#include "world-snapshot.hpp"
+#include "component-pool.hpp"
+#include "../memory/arena.hpp"
 #include "components/camera.hpp"
 
 #include <iostream>
@@ -9,11 +17,42 @@ using std::cout;
 
 namespace our {
 
+    class PhysicsQueries;
+
     // This class holds a set of entities
     class World {
-        std::unordered_set<Entity*> entities; // These are the entities held by this world
+        Arena arena; // The level arena from which the entities and the components are allocated, it is released all at once by "clear"
+        EntityStorage entities{&arena}; // These are the entities held by this world (stored in a slot map)
         std::unordered_set<Entity*> markedForRemoval; // These are the entities that are awaiting to be deleted
                                                       // when deleteMarkedEntities is called
+        size_t entitiesVersion = 0; // Incremented whenever entities are added or deleted so systems can tell when to rebuild their caches
+        ComponentStorage componentStorage{&arena}; // The components of all the entities in this world are stored in these pools
+        CommandBuffer commands; // The structural changes recorded while the systems are running, they are applied at the sync points
+        std::unordered_map<ComponentMask, std::vector<Entity*>> views; // The cached result of every view requested so far
+                                                                       // keyed by the mask of the components in the view
+        PhysicsQueries* physicsQueries = nullptr; // Answers the spatial queries (raycasts, overlaps) about the rigid bodies, it is owned by the state
+
+        // Adds the entity to (or removes it from) every cached view whose membership changed
+        // since the entity had the components in "previousMask"
+        void updateViews(Entity* entity, const ComponentMask& previousMask) {
+            if (markedForRemoval.find(entity) != markedForRemoval.end()) return;
+            const ComponentMask& currentMask = entity->getComponentMask();
+            for (auto& [mask, matches] : views)
+            {
+                bool wasMatching = (previousMask & mask) == mask;
+                bool isMatching = (currentMask & mask) == mask;
+                if (isMatching && !wasMatching)
+                    matches.push_back(entity);
+                else if (wasMatching && !isMatching)
+                    removeFromView(matches, entity);
+            }
+        }
+
+        static void removeFromView(std::vector<Entity*>& matches, Entity* entity) {
+            matches.erase(std::find(matches.begin(), matches.end(), entity));
+        }
+
+        friend Entity; // The entity is a friend since it has to notify the world whenever its components change
     public:
 
         World() = default;
@@ -23,7 +62,8 @@ namespace our {
         // If any of the entities has children, this function will be called recursively for these children
         void deserialize(const nlohmann::json& data, Entity* parent = nullptr);
 
-        // This adds an entity to the entities set and returns a pointer to that entity
+        // This adds an entity to the entities storage and returns a pointer to that entity
+        // The pointer stays valid until the entity is deleted, use "getHandle" to keep a reference that can be checked later
         // WARNING The entity is owned by this world so don't use "delete" to delete it, instead, call "markForRemoval"
         // to put it in the "markedForRemoval" set. The elements in the "markedForRemoval" set will be removed and
         // deleted when "deleteMarkedEntities" is called.
@@ -31,35 +71,108 @@ namespace our {
             //TODO: (Req 8) Create a new entity, set its world member variable to this,
             // and don't forget to insert it in the suitable container.
             
-            Entity* entity = new Entity;
+            Entity* entity = entities.create();
             entity->world = this;
-            entities.insert(entity);
+            entity->storage = &componentStorage;
+            entitiesVersion++;
             return entity;
         }
 
-        // This returns and immutable reference to the set of all entites in the world.
-        const std::unordered_set<Entity*>& getEntities() {
-            return entities;
+        // This returns and immutable reference to the dense list of all entites in the world.
+        const std::vector<Entity*>& getEntities() {
+            return entities.getEntities();
+        }
+
+        // This returns the entity referred to by the handle, or null if the entity was deleted
+        Entity* get(EntityHandle handle) const {
+            return entities.get(handle);
+        }
+
+        // This returns true if the handle refers to an entity that still exists in this world
+        bool isAlive(EntityHandle handle) const {
+            return entities.isAlive(handle);
+        }
+
+        // This returns a number that changes whenever entities are added to or deleted from the world
+        size_t getEntitiesVersion() const {
+            return entitiesVersion;
+        }
+
+        // This returns an immutable reference to the dense list of all the components of type T in the world.
+        // Systems that only care about one component type should iterate over this list instead of the entities.
+        template<typename T>
+        const std::vector<T*>& getComponents() {
+            return componentStorage.getComponents<T>();
+        }
+
+        // This returns the list of entities that hold a component of every type in Ts (e.g. view<MovementComponent, RigidBodyComponent>())
+        // The list is built once on the first call, then the world keeps it up to date whenever
+        // a component is added or deleted and whenever an entity is marked for removal.
+        // So the systems only pay for the entities they actually use.
+        template<typename... Ts>
+        const std::vector<Entity*>& view() {
+            ComponentMask mask;
+            (mask.set(componentTypeID<Ts>()), ...);
+            auto [it, inserted] = views.try_emplace(mask);
+            if (inserted)
+            {
+                for (Entity* entity : entities.getEntities())
+                {
+                    if ((entity->getComponentMask() & mask) == mask && markedForRemoval.find(entity) == markedForRemoval.end())
+                        it->second.push_back(entity);
+                }
+            }
+            return it->second;
+        }
+
+        // This saves the transforms of all the entities and the state of the components that support snapshots into a binary blob
+        WorldSnapshot snapshot();
+
+        // This restores the state saved in the snapshot, the entities that were deleted since the snapshot are skipped
+        // The restored entities are not interpolated from their state before the restore (it is a teleport)
+        void restore(const WorldSnapshot& snapshot);
+
+        // This returns the command buffer of the world
+        // Systems that run in parallel must not add or remove entities or components directly,
+        // instead they record these changes in the command buffer and the scheduler applies them at the next sync point
+        CommandBuffer& getCommandBuffer() {
+            return commands;
+        }
+
+        // This sets the object that answers the spatial queries about the rigid bodies of this world
+        void setPhysicsQueries(PhysicsQueries* queries) {
+            physicsQueries = queries;
+        }
+
+        // This returns the object that answers the spatial queries about the rigid bodies of this world (null if there is none)
+        PhysicsQueries* getPhysicsQueries() const {
+            return physicsQueries;
         }
 
         // This marks an entity for removal by adding it to the "markedForRemoval" set.
         // The elements in the "markedForRemoval" set will be removed and deleted when "deleteMarkedEntities" is called.
         void markForRemoval(Entity* entity){
             //TODO: (Req 8) If the entity is in this world, add it to the "markedForRemoval" set.
-            if (entities.find(entity) != entities.end())
+            if (entities.contains(entity) && markedForRemoval.insert(entity).second)
             {
-                markedForRemoval.insert(entity);
+                // The entity should no longer be visible to the systems
+                const ComponentMask& entityMask = entity->getComponentMask();
+                for (auto& [mask, matches] : views)
+                {
+                    if ((entityMask & mask) == mask)
+                        removeFromView(matches, entity);
+                }
             }
         }
 
-        // This removes the elements in "markedForRemoval" from the "entities" set.
-        // Then each of these elements are deleted.
+        // This removes the elements in "markedForRemoval" from the "entities" storage.
+        // Then each of these elements are deleted and their slots are recycled.
         void deleteMarkedEntities(){
             //TODO: (Req 8) Remove and delete all the entities that have been marked for removal
             for (auto entity : markedForRemoval)
             {
-                entities.erase(entity);
-                delete entity;
+                entities.destroy(entity);
+                entitiesVersion++;
             }
             markedForRemoval.clear();
         }
@@ -71,8 +184,14 @@ namespace our {
             deleteMarkedEntities();
 
             // remove remaining elements
-            for (auto entity: entities) delete entity;
-            entities.clear();
+            views.clear();
+            entities.releaseMemory();
+            entitiesVersion++;
+
+            // all the components were returned to their pools, so we can delete the pools
+            // then the memory of all the entities and components is released at once
+            componentStorage.clear();
+            arena.reset();
         }
 
         // TODO: remove this if not used later
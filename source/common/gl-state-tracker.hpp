@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // The state tracker remembers the OpenGL state that was set through it and skips the calls that would not change anything
+    // (e.g. binding the program that is already in use or enabling blending while it is enabled).
+    // Everything that changes the tracked state should go through the tracker, otherwise what it remembers is wrong.
+    // Code that changes the state directly (e.g. the GUI) should be followed by a call to "invalidate".
+    // NOTE: like every OpenGL call, the tracker should only be used from the thread that owns the context
+    class GLStateTracker
+    {
+        // A value of the state and whether it is known (an unknown value is always sent)
+        template <typename T>
+        struct Tracked
+        {
+            T value{};
+            bool known = false;
+        };
+
+        static constexpr GLuint TRACKED_TEXTURE_UNITS = 16; // The bindings of the units after these are not tracked
+
+        Tracked<bool> cullFace, depthTest, blend;
+        Tracked<GLenum> culledFace, frontFace, depthFunction, blendEquation;
+        Tracked<glm::uvec2> blendFunction; // The source and destination factors
+        Tracked<glm::vec4> blendColor;
+        Tracked<glm::bvec4> colorMask;
+        Tracked<bool> depthMask;
+        Tracked<GLuint> program, vertexArray, activeTexture;
+        Tracked<GLuint> textures[TRACKED_TEXTURE_UNITS], samplers[TRACKED_TEXTURE_UNITS];
+
+        uint64_t issuedCount = 0, skippedCount = 0;
+
+        // Returns true if the call has to be issued (the value is unknown or different) and remembers the new value
+        template <typename T>
+        bool change(Tracked<T> &state, const T &value)
+        {
+            if (state.known && state.value == value)
+            {
+                skippedCount++;
+                return false;
+            }
+            state.value = value;
+            state.known = true;
+            issuedCount++;
+            return true;
+        }
+
+        Tracked<bool> *getCapability(GLenum capability)
+        {
+            switch (capability)
+            {
+            case GL_CULL_FACE:
+                return &cullFace;
+            case GL_DEPTH_TEST:
+                return &depthTest;
+            case GL_BLEND:
+                return &blend;
+            default:
+                return nullptr;
+            }
+        }
+
+        // Forgets the units to which the given object is bound (deleting a bound object resets the binding to 0)
+        static void forget(Tracked<GLuint> *bindings, GLuint count, GLuint name)
+        {
+            for (GLuint index = 0; index < count; index++)
+                if (bindings[index].known && bindings[index].value == name)
+                    bindings[index].value = 0;
+        }
+
+        GLStateTracker() = default;
+
+    public:
+        static GLStateTracker *getInstance()
+        {
+            static GLStateTracker instance;
+            return &instance;
+        }
+
+        void setEnabled(GLenum capability, bool enabled)
+        {
+            if (Tracked<bool> *state = getCapability(capability))
+            {
+                if (!change(*state, enabled))
+                    return;
+            }
+            else
+            {
+                issuedCount++;
+            }
+            if (enabled)
+                glEnable(capability);
+            else
+                glDisable(capability);
+        }
+
+        void setCullFace(GLenum face)
+        {
+            if (change(culledFace, face))
+                glCullFace(face);
+        }
+
+        void setFrontFace(GLenum winding)
+        {
+            if (change(frontFace, winding))
+                glFrontFace(winding);
+        }
+
+        void setDepthFunction(GLenum function)
+        {
+            if (change(depthFunction, function))
+                glDepthFunc(function);
+        }
+
+        void setBlendEquation(GLenum equation)
+        {
+            if (change(blendEquation, equation))
+                glBlendEquation(equation);
+        }
+
+        void setBlendFunction(GLenum sourceFactor, GLenum destinationFactor)
+        {
+            if (change(blendFunction, glm::uvec2(sourceFactor, destinationFactor)))
+                glBlendFunc(sourceFactor, destinationFactor);
+        }
+
+        void setBlendColor(glm::vec4 color)
+        {
+            if (change(blendColor, color))
+                glBlendColor(color.r, color.g, color.b, color.a);
+        }
+
+        void setColorMask(glm::bvec4 mask)
+        {
+            if (change(colorMask, mask))
+                glColorMask(mask.r, mask.g, mask.b, mask.a);
+        }
+
+        void setDepthMask(bool mask)
+        {
+            if (change(depthMask, mask))
+                glDepthMask(mask);
+        }
+
+        void useProgram(GLuint name)
+        {
+            if (change(program, name))
+                glUseProgram(name);
+        }
+
+        void bindVertexArray(GLuint name)
+        {
+            if (change(vertexArray, name))
+                glBindVertexArray(name);
+        }
+
+        // Selects the texture unit (an index, not GL_TEXTUREi) to which the next textures are bound
+        void setActiveTexture(GLuint unit)
+        {
+            if (change(activeTexture, unit))
+                glActiveTexture(GL_TEXTURE0 + unit);
+        }
+
+        // Binds the texture to GL_TEXTURE_2D of the active texture unit
+        void bindTexture2D(GLuint name)
+        {
+            if (activeTexture.known && activeTexture.value < TRACKED_TEXTURE_UNITS)
+            {
+                if (!change(textures[activeTexture.value], name))
+                    return;
+            }
+            else
+            {
+                issuedCount++;
+            }
+            glBindTexture(GL_TEXTURE_2D, name);
+        }
+
+        void bindSampler(GLuint unit, GLuint name)
+        {
+            if (unit < TRACKED_TEXTURE_UNITS)
+            {
+                if (!change(samplers[unit], name))
+                    return;
+            }
+            else
+            {
+                issuedCount++;
+            }
+            glBindSampler(unit, name);
+        }
+
+        // These should be called when an object is deleted, since OpenGL may give its name to a new object
+        void forgetProgram(GLuint name)
+        {
+            if (program.value == name)
+                program.known = false; // A deleted program stays in use until another one is used
+        }
+        void forgetVertexArray(GLuint name) { forget(&vertexArray, 1, name); }
+        void forgetTexture(GLuint name) { forget(textures, TRACKED_TEXTURE_UNITS, name); }
+        void forgetSampler(GLuint name) { forget(samplers, TRACKED_TEXTURE_UNITS, name); }
+
+        // Forgets the whole state, so the next call of every kind is issued
+        void invalidate()
+        {
+            for (Tracked<bool> *state : {&cullFace, &depthTest, &blend, &depthMask})
+                state->known = false;
+            for (Tracked<GLuint> *state : {&culledFace, &frontFace, &depthFunction, &blendEquation, &program, &vertexArray, &activeTexture})
+                state->known = false;
+            blendFunction.known = blendColor.known = colorMask.known = false;
+            for (GLuint unit = 0; unit < TRACKED_TEXTURE_UNITS; unit++)
+                textures[unit].known = samplers[unit].known = false;
+        }
+
+        // The number of calls sent to OpenGL and the number of calls skipped since the counters were reset
+        uint64_t getIssuedCount() const { return issuedCount; }
+        uint64_t getSkippedCount() const { return skippedCount; }
+        void resetCounters() { issuedCount = skippedCount = 0; }
+
+        GLStateTracker(const GLStateTracker &) = delete;
+        GLStateTracker &operator=(const GLStateTracker &) = delete;
+    };
+
+}
@@ -0,0 +1,111 @@
+#include "thread-pool.hpp"
+
+namespace our {
+
+    thread_local int ThreadPool::workerIndex = -1;
+
+    ThreadPool *ThreadPool::getInstance() {
+        // The pool is destroyed (and its workers are joined) when the program exits
+        static ThreadPool instance([]() {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }());
+        return &instance;
+    }
+
+    ThreadPool::ThreadPool(size_t workerCount) {
+        for (size_t index = 0; index <= workerCount; index++)
+            queues.push_back(std::make_unique<TaskQueue>());
+        for (size_t index = 0; index < workerCount; index++)
+            workers.emplace_back(&ThreadPool::workerLoop, this, (int)index);
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        sleepCondition.notify_all();
+        for (auto &worker : workers) worker.join();
+    }
+
+    void ThreadPool::submit(TaskGroup &group, std::function<void()> task) {
+        group.remaining.fetch_add(1, std::memory_order_relaxed);
+        auto wrapped = [this, &group, task = std::move(task)]() {
+            task();
+            // The group may be destroyed as soon as its counter reaches zero, so it is not touched after that
+            if (group.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                doneCondition.notify_all();
+            }
+        };
+        // The counter is incremented first so that it never goes below zero when a thief takes the task right after it is pushed
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            queuedTasks.fetch_add(1, std::memory_order_release);
+        }
+        // Workers push to their own queue (to keep the data in their cache), other threads push to the shared queue
+        TaskQueue &queue = *queues[workerIndex >= 0 ? workerIndex : workers.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(wrapped));
+        }
+        sleepCondition.notify_one();
+    }
+
+    bool ThreadPool::popTask(std::function<void()> &task) {
+        size_t queueCount = queues.size();
+        size_t ownIndex = workerIndex >= 0 ? workerIndex : workers.size();
+        // First, we pop the newest task from our own queue
+        {
+            TaskQueue &queue = *queues[ownIndex];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+                queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        // Then we steal the oldest task from the other queues
+        for (size_t offset = 1; offset < queueCount; offset++) {
+            TaskQueue &queue = *queues[(ownIndex + offset) % queueCount];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ThreadPool::workerLoop(int index) {
+        workerIndex = index;
+        std::function<void()> task;
+        while (true) {
+            if (popTask(task)) {
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCondition.wait(lock, [this]() { return stopping || queuedTasks.load(std::memory_order_acquire) > 0; });
+            if (stopping) return;
+        }
+    }
+
+    void ThreadPool::wait(TaskGroup &group) {
+        std::function<void()> task;
+        while (!group.isDone()) {
+            if (popTask(task)) {
+                task();
+                continue;
+            }
+            // Nothing is left to take, so the remaining tasks of the group are running on the workers
+            std::unique_lock<std::mutex> lock(doneMutex);
+            doneCondition.wait(lock, [&group]() { return group.isDone(); });
+        }
+    }
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace our {
+
+    // A task group counts the tasks that were submitted to the thread pool and did not finish yet
+    // It is used to wait for a batch of tasks (see "ThreadPool::wait")
+    class TaskGroup {
+        std::atomic<size_t> remaining{0};
+        friend class ThreadPool;
+    public:
+        bool isDone() const { return remaining.load(std::memory_order_acquire) == 0; }
+    };
+
+    // A work-stealing thread pool
+    // Every worker thread owns a queue of tasks. A worker pops the newest task from its own queue,
+    // and when its queue is empty, it steals the oldest task from the queues of the other threads.
+    // Threads that are not workers (e.g. the main thread) push their tasks to a shared queue, and while they wait
+    // for a task group, they help by executing the pending tasks and only block when there is nothing left to take.
+    class ThreadPool {
+        struct TaskQueue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        static thread_local int workerIndex; // The index of the current thread in "workers" (-1 if it is not a worker)
+
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<TaskQueue>> queues; // One queue per worker followed by the shared queue of the other threads
+        std::atomic<size_t> queuedTasks{0}; // The number of tasks that are waiting in the queues
+        std::atomic<bool> stopping{false};
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition; // Idle workers sleep on this condition until a task is submitted
+        std::mutex doneMutex;
+        std::condition_variable doneCondition; // Waiting threads sleep on this condition until a task group is done
+
+        ThreadPool(size_t workerCount);
+
+        void workerLoop(int index);
+        bool popTask(std::function<void()> &task); // Takes a task from the current thread queue or steals it from another queue
+
+    public:
+        // Returns the thread pool (it is created on the first call with one worker for each hardware thread except the main thread)
+        static ThreadPool *getInstance();
+
+        ~ThreadPool();
+
+        // Returns the number of threads that execute tasks while the main thread waits (the workers and the main thread)
+        size_t getThreadCount() const { return workers.size() + 1; }
+
+        // Submits a task to be executed by any thread, the task is counted in the given group until it finishes
+        void submit(TaskGroup &group, std::function<void()> task);
+
+        // Executes pending tasks on the calling thread until all the tasks of the group are done
+        // When no task is left in the queues, the calling thread sleeps until the running tasks of the group finish
+        void wait(TaskGroup &group);
+
+        // Splits the range [0, count) into chunks of at least "grainSize" elements and calls "body(begin, end)" for every chunk in parallel
+        // The calling thread also executes chunks and the function returns when all the chunks are done
+        template<typename Body>
+        void parallelFor(size_t count, size_t grainSize, const Body &body) {
+            if (count == 0) return;
+            if (grainSize == 0) grainSize = 1;
+            size_t chunkCount = std::min((count + grainSize - 1) / grainSize, getThreadCount() * 4);
+            if (chunkCount <= 1) {
+                body(size_t(0), count);
+                return;
+            }
+            size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+            TaskGroup group;
+            // The first chunk is kept for the calling thread
+            for (size_t begin = chunkSize; begin < count; begin += chunkSize) {
+                size_t end = std::min(begin + chunkSize, count);
+                submit(group, [&body, begin, end]() { body(begin, end); });
+            }
+            body(size_t(0), std::min(chunkSize, count));
+            wait(group);
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+    };
+
+}
@@ -36,7 +36,8 @@ namespace our
     {
         // TODO: (Req 7) Write this function
         Material::setup();
-        shader->set("tint", tint);
+        static const UniformId tintId("tint");
+        shader->set(tintId, tint);
     }
 
     // This function read the material data from a json object
@@ -55,12 +56,13 @@ namespace our
     {
         // TODO: (Req 7) Write this function
         TintedMaterial::setup();
-        shader->set("alphaThreshold", alphaThreshold);
-        glActiveTexture(GL_TEXTURE0);
+        static const UniformId alphaThresholdId("alphaThreshold"), textureId("tex");
+        shader->set(alphaThresholdId, alphaThreshold);
+        GLStateTracker::getInstance()->setActiveTexture(0);
         texture->bind();
         if (sampler)
             sampler->bind(0);
-        shader->set("tex", 0);
+        shader->set(textureId, 0);
     }
 
     // This function read the material data from a json object
@@ -77,15 +79,19 @@ namespace our
     void LitMaterial::setup() const
     {
         Material::setup();
-        shader->set("mat.ambient", ambient);
-        shader->set("mat.diffuse", diffuse);
-        shader->set("mat.specular", specular);
-        shader->set("mat.emission", emission);
-        shader->set("mat.roughness", roughness);
-        shader->set("mat.SpecularExponent", SpecularExponent);
-        shader->set("mat.refractionFactor", refractionFactor);
-        shader->set("mat.dissolveFactor", dissolveFactor);
-        shader->set("mat.illumModel", illumModel);
+        // The ids of the material fields are created once (setting a uniform by its id does not build or hash the name)
+        static const UniformId ids[] = {UniformId("mat.ambient"), UniformId("mat.diffuse"), UniformId("mat.specular"),
+                                        UniformId("mat.emission"), UniformId("mat.roughness"), UniformId("mat.SpecularExponent"),
+                                        UniformId("mat.refractionFactor"), UniformId("mat.dissolveFactor"), UniformId("mat.illumModel")};
+        shader->set(ids[0], ambient);
+        shader->set(ids[1], diffuse);
+        shader->set(ids[2], specular);
+        shader->set(ids[3], emission);
+        shader->set(ids[4], roughness);
+        shader->set(ids[5], SpecularExponent);
+        shader->set(ids[6], refractionFactor);
+        shader->set(ids[7], dissolveFactor);
+        shader->set(ids[8], illumModel);
     }
 
     void LitMaterial::deserialize(const nlohmann::json &data)
@@ -106,11 +112,12 @@ namespace our
     void LitTexturedMaterial::setup() const
     {
         LitMaterial::setup();
-        glActiveTexture(GL_TEXTURE0);
+        static const UniformId textureId("tex");
+        GLStateTracker::getInstance()->setActiveTexture(0);
         texture->bind();
         if (sampler)
             sampler->bind(0);
-        shader->set("tex", 0);
+        shader->set(textureId, 0);
     }
     void LitTexturedMaterial::deserialize(const nlohmann::json &data)
     {
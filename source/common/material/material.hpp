@@ -28,6 +28,8 @@ namespace our
         virtual void setup() const;
         // This function read a material from a json object
         virtual void deserialize(const nlohmann::json &data);
+        // Returns true if the material needs the lighting uniforms (so the renderer does not need RTTI to know it)
+        virtual bool isLit() const { return false; }
     };
 
     // This material adds a uniform for a tint (a color that will be sent to the shader)
@@ -72,6 +74,7 @@ namespace our
 
         void setup() const override;
         void deserialize(const nlohmann::json &data) override;
+        bool isLit() const override { return true; }
     };
 
     class LitTexturedMaterial : public LitMaterial
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../gl-state-tracker.hpp"
+
 #include <glad/gl.h>
 #include <glm/vec4.hpp>
 #include <json/json.hpp>
@@ -44,41 +46,29 @@ namespace our
 
         // This function should set the OpenGL options to the values specified by this structure
         // For example, if faceCulling.enabled is true, you should call glEnable(GL_CULL_FACE), otherwise, you should call glDisable(GL_CULL_FACE)
+        // The calls go through the state tracker, so the options that did not change since the last draw cost nothing
         void setup() const
         {
             // TODO: (Req 4) Write this function
+            GLStateTracker *state = GLStateTracker::getInstance();
+            state->setEnabled(GL_CULL_FACE, faceCulling.enabled);
             if (faceCulling.enabled)
             {
-                glEnable(GL_CULL_FACE);
-                glCullFace(faceCulling.culledFace);
-                glFrontFace(faceCulling.frontFace);
-            }
-            else
-            {
-                glDisable(GL_CULL_FACE);
+                state->setCullFace(faceCulling.culledFace);
+                state->setFrontFace(faceCulling.frontFace);
             }
+            state->setEnabled(GL_DEPTH_TEST, depthTesting.enabled);
             if (depthTesting.enabled)
-            {
-                glEnable(GL_DEPTH_TEST);
-                glDepthFunc(depthTesting.function);
-            }
-            else
-            {
-                glDisable(GL_DEPTH_TEST);
-            }
+                state->setDepthFunction(depthTesting.function);
+            state->setEnabled(GL_BLEND, blending.enabled);
             if (blending.enabled)
             {
-                glEnable(GL_BLEND);
-                glBlendEquation(blending.equation);
-                glBlendFunc(blending.sourceFactor, blending.destinationFactor);
-                glBlendColor(blending.constantColor.r, blending.constantColor.g, blending.constantColor.b, blending.constantColor.a);
-            }
-            else
-            {
-                glDisable(GL_BLEND);
+                state->setBlendEquation(blending.equation);
+                state->setBlendFunction(blending.sourceFactor, blending.destinationFactor);
+                state->setBlendColor(blending.constantColor);
             }
-            glColorMask(colorMask.r, colorMask.g, colorMask.b, colorMask.a);
-            glDepthMask(depthMask);
+            state->setColorMask(colorMask);
+            state->setDepthMask(depthMask);
         }
 
         // Given a json object, this function deserializes a PipelineState structure
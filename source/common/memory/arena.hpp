@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace our {
+
+    // An arena is a linear (bump) allocator.
+    // Allocating is just moving an offset forward inside a block of memory, and there is no way to free a single allocation.
+    // Instead, all the allocations are released at once by calling "reset" which only rewinds the offset,
+    // so the blocks are kept and reused by the next allocations without going back to the system allocator.
+    // NOTE: The arena only manages memory, the owner of the objects constructed in it must still call their destructors.
+    class Arena {
+        struct Block {
+            std::unique_ptr<std::byte[]> memory;
+            size_t size;
+        };
+
+        std::vector<Block> blocks; // The blocks allocated so far (they are kept after a reset to be reused)
+        size_t currentBlock = 0; // The index of the block from which we are currently allocating
+        size_t offset = 0; // The number of bytes used in the current block
+        size_t blockSize; // The default size of a block
+
+        static size_t alignUp(size_t value, size_t alignment){
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+    public:
+        explicit Arena(size_t blockSize = 64 * 1024) : blockSize(blockSize) {}
+
+        // Allocates "size" bytes aligned to "alignment" (which must be a power of 2)
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)){
+            while(currentBlock < blocks.size()){
+                Block& block = blocks[currentBlock];
+                uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+                size_t start = alignUp(base + offset, alignment) - base;
+                if(start + size <= block.size){
+                    offset = start + size;
+                    return block.memory.get() + start;
+                }
+                // The block is full, so we move to the next one (if any)
+                currentBlock++;
+                offset = 0;
+            }
+            // We ran out of blocks, so we add a new one that is big enough for this allocation
+            size_t newBlockSize = std::max(blockSize, size + alignment);
+            blocks.push_back({std::unique_ptr<std::byte[]>(new std::byte[newBlockSize]), newBlockSize});
+            currentBlock = blocks.size() - 1;
+            offset = 0;
+            return allocate(size, alignment);
+        }
+
+        // Allocates an uninitialized array of "count" elements of type T
+        template<typename T>
+        T* allocateArray(size_t count){
+            return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        // Releases all the allocations at once, the memory blocks are kept to be reused
+        void reset(){
+            currentBlock = 0;
+            offset = 0;
+        }
+
+        // Releases all the allocations and gives the memory blocks back to the system
+        void release(){
+            blocks.clear();
+            reset();
+        }
+
+        // Returns the number of bytes reserved by the arena from the system
+        size_t getCapacity() const {
+            size_t capacity = 0;
+            for(const Block& block : blocks) capacity += block.size;
+            return capacity;
+        }
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+    };
+
+    // An STL allocator that allocates from an arena, so it can be used with the standard containers.
+    // Deallocating does nothing, the memory is reclaimed when the arena is reset.
+    template<typename T>
+    class ArenaAllocator {
+        template<typename U> friend class ArenaAllocator;
+        Arena* arena;
+    public:
+        using value_type = T;
+
+        ArenaAllocator(Arena& arena) : arena(&arena) {}
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+        T* allocate(size_t count){ return arena->allocateArray<T>(count); }
+        void deallocate(T*, size_t){}
+
+        template<typename U>
+        bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+        template<typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+    };
+
+}
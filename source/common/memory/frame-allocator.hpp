@@ -0,0 +1,28 @@
+#pragma once
+
+#include "arena.hpp"
+#include <vector>
+
+namespace our {
+
+    // Returns the arena used for scratch data that only lives during the current frame
+    // The application resets it at the end of every frame, so nothing allocated from it should be kept to the next frame
+    inline Arena& getFrameArena(){
+        static Arena frameArena(1024 * 1024);
+        return frameArena;
+    }
+
+    // An STL allocator that allocates from the frame arena
+    template<typename T>
+    class FrameAllocator : public ArenaAllocator<T> {
+    public:
+        FrameAllocator() : ArenaAllocator<T>(getFrameArena()) {}
+        template<typename U>
+        FrameAllocator(const FrameAllocator<U>&) : ArenaAllocator<T>(getFrameArena()) {}
+    };
+
+    // A vector whose elements are allocated from the frame arena (it must not outlive the current frame)
+    template<typename T>
+    using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+}
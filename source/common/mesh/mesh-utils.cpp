@@ -84,6 +84,29 @@ our::Mesh* our::mesh_utils::loadOBJ(const std::string& filename) {
     return new our::Mesh(vertices, elements);
 }
 
+bool our::mesh_utils::loadOBJTriangles(const std::string& filename, std::vector<glm::vec3>& positions, std::vector<unsigned int>& elements) {
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename.c_str())) {
+        std::cerr << "Failed to load obj file \"" << filename << "\" due to error: " << err << std::endl;
+        return false;
+    }
+
+    // The positions are shared by all the shapes, so they are used as they are (without the normals and the texture coordinates)
+    positions.clear();
+    for (size_t index = 0; index + 2 < attrib.vertices.size(); index += 3)
+        positions.push_back({attrib.vertices[index], attrib.vertices[index + 1], attrib.vertices[index + 2]});
+
+    elements.clear();
+    for (const auto &shape : shapes)
+        for (const auto &index : shape.mesh.indices)
+            elements.push_back(static_cast<unsigned int>(index.vertex_index));
+    return true;
+}
+
 // Create a sphere (the vertex order in the triangles are CCW from the outside)
 // Segments define the number of divisions on the both the latitude and the longitude
 our::Mesh* our::mesh_utils::sphere(const glm::ivec2& segments){
@@ -2,10 +2,14 @@
 
 #include "mesh.hpp"
 #include <string>
+#include <vector>
 
 namespace our::mesh_utils {
     // Load an ".obj" file into the mesh
     Mesh* loadOBJ(const std::string& filename);
+    // Load only the positions and the triangles (3 indices per triangle) of an ".obj" file into the CPU memory
+    // Returns false if the file could not be loaded
+    bool loadOBJTriangles(const std::string& filename, std::vector<glm::vec3>& positions, std::vector<unsigned int>& elements);
     // Create a sphere (the vertex order in the triangles are CCW from the outside)
     // Segments define the number of divisions on the both the latitude and the longitude
     Mesh* sphere(const glm::ivec2& segments);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../gl-state-tracker.hpp"
+
 #include <glad/gl.h>
 #include "vertex.hpp"
 
@@ -43,7 +45,7 @@ namespace our
 
             // VAO
             glGenVertexArrays(1, &VAO);
-            glBindVertexArray(VAO);
+            GLStateTracker::getInstance()->bindVertexArray(VAO);
 
             // position vec3
             glEnableVertexAttribArray(ATTRIB_LOC_POSITION);
@@ -71,7 +73,8 @@ namespace our
         void draw()
         {
             // TODO: (Req 2) Write this function
-            glBindVertexArray(VAO);
+            // The vertex array is only bound if the last draw used another mesh
+            GLStateTracker::getInstance()->bindVertexArray(VAO);
             glDrawElements(GL_TRIANGLES, elementCount, GL_UNSIGNED_INT, 0);
         }
 
@@ -81,6 +84,7 @@ namespace our
             // TODO: (Req 2) Write this function
             glDeleteBuffers(1, &VBO);
             glDeleteBuffers(1, &EBO);
+            GLStateTracker::getInstance()->forgetVertexArray(VAO);
             glDeleteVertexArrays(1, &VAO);
         }
 
@@ -1,10 +1,46 @@
 #include "shader.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <fstream>
 #include <string>
 
+namespace
+{
+    // The names of the uniform ids, the id of a name is its index
+    struct UniformRegistry
+    {
+        std::unordered_map<std::string, uint32_t> indices = {{"", 0}};
+        std::vector<std::string> names = {""};
+    };
+
+    UniformRegistry &getUniformRegistry()
+    {
+        static UniformRegistry registry;
+        return registry;
+    }
+}
+
+our::UniformId::UniformId(const std::string &name)
+{
+    UniformRegistry &registry = getUniformRegistry();
+    auto [found, inserted] = registry.indices.emplace(name, (uint32_t)registry.names.size());
+    if (inserted)
+        registry.names.push_back(name);
+    index = found->second;
+}
+
+const std::string &our::UniformId::getName(UniformId id)
+{
+    return getUniformRegistry().names[id.index];
+}
+
+size_t our::UniformId::getCount()
+{
+    return getUniformRegistry().names.size();
+}
+
 // Forward definition for error checking functions
 std::string checkForShaderCompilationErrors(GLuint shader);
 std::string checkForLinkingErrors(GLuint program);
@@ -48,7 +84,7 @@ bool our::ShaderProgram::attach(const std::string &filename, GLenum type) const
     return true;
 }
 
-bool our::ShaderProgram::link() const
+bool our::ShaderProgram::link()
 {
     // TODO: Complete this function
     // Note: The function "checkForLinkingErrors" checks if there is
@@ -65,6 +101,51 @@ bool our::ShaderProgram::link() const
         return false;
     }
 
+    // Read the locations of the active uniforms once, so that setting a uniform never asks OpenGL for its location
+    uniformLocations.clear();
+    uniformBlockIndices.clear();
+    slots.clear();
+    GLint uniformCount = 0, maxNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+    std::vector<char> nameBuffer(std::max(maxNameLength, 1));
+    for (GLint index = 0; index < uniformCount; index++)
+    {
+        GLint size;
+        GLenum type;
+        GLsizei length;
+        glGetActiveUniform(program, index, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+        std::string name(nameBuffer.data(), length);
+        GLint location = glGetUniformLocation(program, name.c_str());
+        if (location < 0) // The uniforms inside uniform blocks have no location
+            continue;
+        uniformLocations[name] = location;
+
+        // An array of a basic type is listed once as "name[0]", so its name and all its elements are added
+        const std::string suffix = "[0]";
+        if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+        {
+            std::string arrayName = name.substr(0, name.size() - suffix.size());
+            uniformLocations[arrayName] = location;
+            for (GLint element = 1; element < size; element++)
+            {
+                std::string elementName = arrayName + "[" + std::to_string(element) + "]";
+                uniformLocations[elementName] = glGetUniformLocation(program, elementName.c_str());
+            }
+        }
+    }
+
+    GLint blockCount = 0, maxBlockNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+    nameBuffer.resize(std::max(maxBlockNameLength, 1));
+    for (GLint index = 0; index < blockCount; index++)
+    {
+        GLsizei length;
+        glGetActiveUniformBlockName(program, index, (GLsizei)nameBuffer.size(), &length, nameBuffer.data());
+        uniformBlockIndices[std::string(nameBuffer.data(), length)] = index;
+    }
+
     return true;
 }
 
@@ -1,7 +1,13 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../gl-state-tracker.hpp"
 
 #include <glad/gl.h>
 #include <glm/glm.hpp>
@@ -10,6 +16,20 @@
 namespace our
 {
 
+    // A handle to a uniform name, every name gets the same id in all the shader programs
+    // so the id can be computed once (e.g. by the renderer) and used with any program without building or hashing strings
+    // NOTE: ids should be created from the main thread (the thread that renders)
+    struct UniformId
+    {
+        uint32_t index = 0; // The id 0 is the empty name which is never found in a program
+
+        UniformId() = default;
+        explicit UniformId(const std::string &name);
+
+        static const std::string &getName(UniformId id);
+        static size_t getCount(); // The number of names registered so far
+    };
+
     class ShaderProgram
     {
 
@@ -17,6 +37,55 @@ namespace our
         // Shader Program Handle (OpenGL object name)
         GLuint program;
 
+        // The locations of the active uniforms, read from the program when it is linked
+        // The elements of the arrays are added one by one (e.g. "weights[2]") so they can be found by their full names
+        std::unordered_map<std::string, GLint> uniformLocations;
+        // The indices of the active uniform blocks
+        std::unordered_map<std::string, GLint> uniformBlockIndices;
+
+        // The location of each uniform id in this program and a shadow copy of the last value sent to it
+        struct UniformSlot
+        {
+            GLint location = -1;
+            GLint blockIndex = -1;   // The index of the uniform block with this name (if any)
+            GLint blockBinding = -1; // The binding point the block was last bound to
+            bool resolved = false;
+            bool hasValue = false;
+            unsigned char value[sizeof(glm::mat4)];
+        };
+        std::vector<UniformSlot> slots;
+
+        UniformSlot &getSlot(UniformId id)
+        {
+            if (id.index >= slots.size())
+                slots.resize(UniformId::getCount());
+            UniformSlot &slot = slots[id.index];
+            if (!slot.resolved)
+            {
+                const std::string &name = UniformId::getName(id);
+                slot.location = (GLint)getUniformLocation(name);
+                auto block = uniformBlockIndices.find(name);
+                slot.blockIndex = block != uniformBlockIndices.end() ? block->second : -1;
+                slot.resolved = true;
+            }
+            return slot;
+        }
+
+        // Returns the slot of the uniform if the value has to be sent (the uniform exists and its value changed)
+        template <typename T>
+        UniformSlot *update(UniformId id, const T &value)
+        {
+            static_assert(sizeof(T) <= sizeof(UniformSlot::value), "The uniform value is too big for the shadow copy");
+            UniformSlot &slot = getSlot(id);
+            if (slot.location < 0)
+                return nullptr;
+            if (slot.hasValue && std::memcmp(slot.value, &value, sizeof(T)) == 0)
+                return nullptr;
+            std::memcpy(slot.value, &value, sizeof(T));
+            slot.hasValue = true;
+            return &slot;
+        }
+
     public:
         ShaderProgram()
         {
@@ -27,66 +96,92 @@ namespace our
         {
             // TODO: (Req 1) Delete a shader program
             if (program)
+            {
+                GLStateTracker::getInstance()->forgetProgram(program);
                 glDeleteProgram(this->program);
+            }
         }
 
         bool attach(const std::string &filename, GLenum type) const;
 
-        bool link() const;
+        // Links the program and reads the locations of its active uniforms
+        bool link();
 
         void use()
         {
-            glUseProgram(this->program);
+            GLStateTracker::getInstance()->useProgram(this->program);
         }
 
         GLuint getUniformLocation(const std::string &name)
         {
             // TODO: (Req 1) Return the location of the uniform with the given name
-            return glGetUniformLocation(this->program, name.c_str());
+            auto found = uniformLocations.find(name);
+            return found != uniformLocations.end() ? found->second : -1;
         }
 
-        void set(const std::string &uniform, GLfloat value)
+        // The values are only sent to OpenGL if they differ from the last values sent to the same uniforms
+        void set(UniformId uniform, GLfloat value)
         {
-            // TODO: (Req 1) Send the given float value to the given uniform
-            glUniform1f(getUniformLocation(uniform), value);
+            if (UniformSlot *slot = update(uniform, value))
+                glUniform1f(slot->location, value);
         }
 
-        void set(const std::string &uniform, GLuint value)
+        void set(UniformId uniform, GLuint value)
         {
-            // TODO: (Req 1) Send the given unsigned integer value to the given uniform
-            glUniform1ui(getUniformLocation(uniform), value);
+            if (UniformSlot *slot = update(uniform, value))
+                glUniform1ui(slot->location, value);
         }
 
-        void set(const std::string &uniform, GLint value)
+        void set(UniformId uniform, GLint value)
         {
-            // TODO: (Req 1) Send the given integer value to the given uniform
-            glUniform1i(getUniformLocation(uniform), value);
+            if (UniformSlot *slot = update(uniform, value))
+                glUniform1i(slot->location, value);
         }
 
-        void set(const std::string &uniform, glm::vec2 value)
+        void set(UniformId uniform, glm::vec2 value)
         {
-            // TODO: (Req 1) Send the given 2D vector value to the given uniform
-            glUniform2fv(getUniformLocation(uniform), 1, glm::value_ptr(value));
+            if (UniformSlot *slot = update(uniform, value))
+                glUniform2fv(slot->location, 1, glm::value_ptr(value));
         }
 
-        void set(const std::string &uniform, glm::vec3 value)
+        void set(UniformId uniform, glm::vec3 value)
         {
-            // TODO: (Req 1) Send the given 3D vector value to the given uniform
-            glUniform3fv(getUniformLocation(uniform), 1, glm::value_ptr(value));
+            if (UniformSlot *slot = update(uniform, value))
+                glUniform3fv(slot->location, 1, glm::value_ptr(value));
         }
 
-        void set(const std::string &uniform, glm::vec4 value)
+        void set(UniformId uniform, glm::vec4 value)
         {
-            // TODO: (Req 1) Send the given 4D vector value to the given uniform
-            glUniform4fv(getUniformLocation(uniform), 1, glm::value_ptr(value));
+            if (UniformSlot *slot = update(uniform, value))
+                glUniform4fv(slot->location, 1, glm::value_ptr(value));
         }
 
-        void set(const std::string &uniform, glm::mat4 matrix)
+        void set(UniformId uniform, glm::mat4 matrix)
         {
-            // TODO: (Req 1) Send the given matrix 4x4 value to the given uniform
-            glUniformMatrix4fv(getUniformLocation(uniform), 1, GL_FALSE, glm::value_ptr(matrix));
+            if (UniformSlot *slot = update(uniform, matrix))
+                glUniformMatrix4fv(slot->location, 1, GL_FALSE, glm::value_ptr(matrix));
         }
 
+        // Makes the uniform block with the given name read from the buffer bound to the given binding point
+        // The binding is remembered, so binding the same block again costs no OpenGL call
+        void bindUniformBlock(UniformId block, GLuint binding)
+        {
+            UniformSlot &slot = getSlot(block);
+            if (slot.blockIndex < 0 || slot.blockBinding == (GLint)binding)
+                return;
+            glUniformBlockBinding(program, slot.blockIndex, binding);
+            slot.blockBinding = (GLint)binding;
+        }
+
+        // The name based setters look the id of the name up first
+        void set(const std::string &uniform, GLfloat value) { set(UniformId(uniform), value); }
+        void set(const std::string &uniform, GLuint value) { set(UniformId(uniform), value); }
+        void set(const std::string &uniform, GLint value) { set(UniformId(uniform), value); }
+        void set(const std::string &uniform, glm::vec2 value) { set(UniformId(uniform), value); }
+        void set(const std::string &uniform, glm::vec3 value) { set(UniformId(uniform), value); }
+        void set(const std::string &uniform, glm::vec4 value) { set(UniformId(uniform), value); }
+        void set(const std::string &uniform, glm::mat4 matrix) { set(UniformId(uniform), matrix); }
+
         // TODO: (Req 1) Delete the copy constructor and assignment operator.
         // Question: Why do we delete the copy constructor and assignment operator?
         ShaderProgram(const ShaderProgram &) = delete;
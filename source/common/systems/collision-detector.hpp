@@ -4,6 +4,13 @@
 #include "../components/player-controller.hpp"
 #include "../components/movement.hpp"
 #include "../ecs/world.hpp"
+#include "physics/sweep-and-prune.hpp"
+#include "physics/contact.hpp"
+#include "physics/narrowphase.hpp"
+#include "physics/contact-solver.hpp"
+#include "physics/collision-matrix.hpp"
+#include "physics/physics-queries.hpp"
+#include "../jobs/thread-pool.hpp"
 #include <unordered_set>
 #include <iostream>
 #include <glm/gtx/vector_angle.hpp>
@@ -13,198 +20,106 @@ using glm::vec4, glm::vec3, glm::vec4, glm::mat4, glm::distance;
 using std::cout;
 using std::unordered_set, std::vector, std::max, std::min;
 
-vector<vec3> boundingBox = {
-    vec3(1.0, 1.0, 1.0),
-    vec3(-1.0, 1.0, 1.0), vec3(1.0, -1.0, 1.0), vec3(1.0, 1.0, -1.0),
-    vec3(-1.0, -1.0, 1.0), vec3(1.0, -1.0, -1.0), vec3(-1.0, 1.0, -1.0),
-    vec3(-1.0, -1.0, -1.0)};
-
 namespace our
 {
     class CollisionSystem
     {
-        void moveInLocalSpace(Entity *A, vec3 linear_velocity)
-        {
-            MovementComponent *movement = A->getComponent<MovementComponent>();
-            vec3 current_linear_velocity = movement->forward * movement->current_velocity;
-            vec3 new_linear_velocity = linear_velocity + current_linear_velocity;
-            movement->setSpeed(glm::length(new_linear_velocity));
-            movement->setForward(new_linear_velocity);
-        }
-
         void dontMoveCamera(Entity *playerEntity)
         {
             MovementComponent *movement = playerEntity->getComponent<MovementComponent>();
             movement->stopMovingOneFrame = true;
         }
 
-        // intermediate variables between functions
-        Entity *AOwner, *BOwner;
-        mat4 a_local_to_world, b_local_to_world;
-        vec3 center_a, center_b;
-
-        vector<vec3> generateTransformedCube(mat4 transformationMatrix)
+        // The response of a contact between two tags (it is called once per contact of the tick)
+        typedef void (CollisionSystem::*ContactHandler)(const Contact &contact);
+
+        CollisionMatrix matrix;                        // Which tags interact and which of them are solid
+        ContactHandler handlers[TAG_COUNT][TAG_COUNT] = {}; // The response of every pair of tags (null if there is none)
+
+        SweepAndPrune broadphase; // Finds the pairs of bodies whose bounding boxes overlap
+        vector<Contact> contacts;  // The contacts found in the current tick
+        ContactSolver solver;      // Resolves the contacts between solid bodies with impulses
+        vector<const Contact *> solidContacts; // The contacts given to the solver
+        vector<Collider> colliders;      // The shape of every body in the current tick (in the order of the broadphase proxies)
+        size_t collidersRebuildCount = 0; // The rebuild count of the broadphase when all the colliders were built
+        vector<OBB> boxes;               // The boxes of the colliders (the box-box pairs are tested together by the SIMD kernel)
+        vector<uint32_t> boxIndices;     // The index of the box of every body (only valid for boxes)
+
+        // The minimum number of colliders built by a single task
+        static constexpr size_t COLLIDER_GRAIN_SIZE = 64;
+        // The number of broadphase pairs tested by a block (the blocks do not depend on the number of threads)
+        static constexpr size_t BLOCK_SIZE = 64;
+
+        // The narrowphase splits the broadphase pairs into blocks that are tested in parallel
+        // Every block only writes to its own buffers, then the contacts of the blocks are merged in the order of the pairs,
+        // so the contacts are the same for any number of threads
+        struct NarrowphaseBlock
         {
-            vector<vec3> generatedCube;
-            for (vec3 &vertex : boundingBox)
-            {
-                generatedCube.push_back(transformationMatrix * vec4(vertex, 1.0));
-            }
-            return generatedCube;
-        }
-
-        // ==============================================================================
-        vector<vec3> generateTestAxis(vector<vec3> A_axis, vector<vec3> B_axis)
+            vector<std::pair<uint32_t, uint32_t>> boxPairs; // The box-box pairs of the block as indices in "boxes"
+            vector<uint32_t> boxPairIndices;                // The index of every box-box pair in the broadphase pairs
+            vector<CollisionResult> boxResults;
+            vector<CollisionResult> results; // The result of every pair of the block
+            vector<Contact> contacts;        // The contacts found by the block
+        };
+        vector<NarrowphaseBlock> blocks;
+
+        // The continuous bodies and their centers before they moved in the current tick
+        vector<std::pair<RigidBodyComponent *, vec3>> sweepStarts;
+
+        // A continuous body is only swept if it moved more than this fraction of its radius in the tick
+        static constexpr float SWEEP_THRESHOLD = 0.5f;
+        // The swept body is placed this much inside the surface it hit, so the next contact pass sees the contact
+        static constexpr float SWEEP_SKIN = 0.01f;
+
+        // The events found in the current tick
+        bool goalScored = false, bombHit = false, ballHit = false;
+
+        // The impulse on the ball comes from the contact solver, only the events are handled here
+        void CarHitsBall(const Contact &contact)
         {
-            vector<vec3> normalizedAxis(A_axis);
-            normalizedAxis.insert(normalizedAxis.end(), B_axis.begin(), B_axis.end());
-            for (auto &vecA : A_axis)
-            {
-                for (auto &vecB : B_axis)
-                {
-                    vec3 test = glm::cross(vecA, vecB);
-                    if (glm::length(test) == 0)
-                        continue;
-                    normalizedAxis.push_back(glm::normalize(test));
-                }
-            }
-            return normalizedAxis;
+            dontMoveCamera(contact.get(CAR)->getOwner());
+            ballHit = true;
         }
 
-        float isCollided(RigidBodyComponent *A, RigidBodyComponent *B, bool totalCollision = false)
+        void CarHitsWall(const Contact &contact)
         {
-            AOwner = A->getOwner();
-            BOwner = B->getOwner();
-
-            a_local_to_world = AOwner->getLocalToWorldMatrix();
-            b_local_to_world = BOwner->getLocalToWorldMatrix();
-
-            center_a = getTransitionComponent(a_local_to_world);
-            center_b = getTransitionComponent(b_local_to_world);
-
-            vector<vec3> normalizedAxis = generateTestAxis(A->getBoxNormals(a_local_to_world), B->getBoxNormals(b_local_to_world));
-
-            float min_overlap = (float)INT32_MAX;
-            for (auto &axis : normalizedAxis)
-            {
-                vector<float> AProjectionLimits = A->getProjectionRange(axis, a_local_to_world);
-                vector<float> BProjectionLimits = B->getProjectionRange(axis, b_local_to_world);
-
-                // to make make the first point belongs to A for
-                if (AProjectionLimits[0] > BProjectionLimits[1])
-                    swap(AProjectionLimits, BProjectionLimits);
-
-                if (AProjectionLimits[1] < BProjectionLimits[0])
-                    return 0;
-            }
-
-            return min_overlap;
+            RigidBodyComponent *car = contact.get(CAR), *wall = contact.get(WALL);
+            // a wall without a side (e.g. a mesh) blocks the car along the contact normal
+            vec3 normal = wall->wallType == WallType::NOWALL ? contact.getNormalFrom(wall) : resolveWallNormal(wall);
+            MovementComponent *carMovement = car->getOwner()->getComponent<MovementComponent>();
+
+            // the solver already stopped the car, this keeps it from driving into the wall in the next ticks
+            carMovement->collidedWallNormal = normal;
+            // carMovement->stopMovingOneFrame = true;
         }
 
-        bool CarHitsBall(RigidBodyComponent *car, RigidBodyComponent *ball)
+        void BallEntersGoal(const Contact &)
         {
-            if (car->tag == BALL)
-                std::swap(car, ball);
-
-            float overlap = isCollided(car, ball);
-            if (overlap)
-            {
-                vec3 normal = vec3(0., 0., 0.);
-                
-                MovementComponent* carMovement = car->getOwner()->getComponent<MovementComponent>();
-                vec3 forward = carMovement->getCurrentForwardVector();
-
-                if (glm::length(center_b - center_a) != 0)
-                    normal = glm::normalize(center_b - center_a);
-                else
-                    return false;
-
-                float forceFactor = abs(glm::dot(normal, forward));
-                vec3 linearVelocity = forceFactor * abs(carMovement->current_velocity) * normal;
-
-                dontMoveCamera(AOwner);
-                moveInLocalSpace(BOwner, linearVelocity);
-                return true;
-            }
-            return false;
-        }
-
-        bool CarHitsBomb(RigidBodyComponent *car, RigidBodyComponent *bomb)
-        {
-            if (car->tag == BOMB)
-                std::swap(car, bomb);
-
-            if (isCollided(car, bomb))
-            {
-                return true;
-            }
-            return false;
-        }
-
-        bool BallHitsBomb(RigidBodyComponent *ball, RigidBodyComponent *bomb)
-        {
-            if (ball->tag == BOMB)
-                std::swap(ball, bomb);
-
-            if (isCollided(ball, bomb))
-            {
-                return true;
-            }
-            return false;
+            goalScored = true;
         }
 
-        void BallHitsWall(RigidBodyComponent *ball, RigidBodyComponent *wall)
+        void BombHits(const Contact &)
         {
-            if (ball->tag == WALL)
-                std::swap(ball, wall);
-
-            if (isCollided(ball, wall))
-            {
-                vec3 normal = resolveWallNormal(wall);
-
-                MovementComponent *ballMovement = AOwner->getComponent<MovementComponent>();
-
-                float velocity = ballMovement->current_velocity;
-                vec3 normalizedVelocity = ballMovement->forward;
-
-                vec3 reflectionVec = normalizedVelocity - 2.0f * glm::dot(normal, normalizedVelocity) * normal;
-                if (glm::length(reflectionVec) != 0)
-                    reflectionVec = glm::normalize(reflectionVec);
-
-                ballMovement->adjustSpeed(0.2f); // to make it get away from the wall
-                ballMovement->setForward(reflectionVec);
-            }
+            bombHit = true;
         }
 
-        void CarHitsWall(RigidBodyComponent *car, RigidBodyComponent *wall)
+        // Sets the response of the contacts between the two tags (in any order)
+        void setHandler(Tag a, Tag b, ContactHandler handler)
         {
-            if (car->tag == WALL)
-                std::swap(car, wall);
-
-            if (isCollided(car, wall))
-            {
-                vec3 normal = resolveWallNormal(wall);
-                MovementComponent *carMovement = AOwner->getComponent<MovementComponent>();
-
-                carMovement->current_velocity = 0;
-                carMovement->collidedWallNormal = normal;
-                // carMovement->stopMovingOneFrame = true;
-            }
+            handlers[a][b] = handler;
+            handlers[b][a] = handler;
         }
 
-        bool VarCheckPossibleGoal(RigidBodyComponent *ball, RigidBodyComponent *goal)
+        // A sleeping body wakes up when a moving body touches it
+        // (idle bodies do not wake each other up, so a pile of touching bodies can still fall asleep)
+        static void wakeUpTouched(const Contact &contact)
         {
-            if (ball->tag == Tag::WALL)
-                std::swap(ball, goal);
-
-            bool applyTotalCollision = true;
-            if (isCollided(ball, goal, applyTotalCollision))
-            {
-                // TODO: we must do something to declare winning
-                std::cout << "YAY" << std::endl;
-                return true;
-            }
-            return false;
+            MovementComponent *first = contact.first->getOwner()->getComponent<MovementComponent>();
+            MovementComponent *second = contact.second->getOwner()->getComponent<MovementComponent>();
+            if (first != nullptr && first->sleeping && second != nullptr && !second->isIdle())
+                first->wakeUp();
+            if (second != nullptr && second->sleeping && first != nullptr && !first->isIdle())
+                second->wakeUp();
         }
 
         vec3 resolveWallNormal(RigidBodyComponent *wall)
@@ -242,201 +157,194 @@ namespace our
         }
 
     public:
-        static vec3 getTransitionComponent(mat4 translationMatrix)
+        CollisionSystem()
         {
-            return vec3(translationMatrix[3][0], translationMatrix[3][1], translationMatrix[3][2]);
+            matrix.setSolid(CAR, BALL);
+            matrix.setSolid(CAR, WALL);
+            matrix.setSolid(CAR, CAR);
+            matrix.setSolid(BALL, WALL);
+            matrix.setSolid(BALL, BALL);
+            matrix.setTrigger(BALL, GOAL);
+            matrix.setTrigger(BOMB, CAR);
+            matrix.setTrigger(BOMB, BALL);
+
+            setHandler(CAR, BALL, &CollisionSystem::CarHitsBall);
+            setHandler(CAR, WALL, &CollisionSystem::CarHitsWall);
+            setHandler(BALL, GOAL, &CollisionSystem::BallEntersGoal);
+            setHandler(BOMB, CAR, &CollisionSystem::BombHits);
+            setHandler(BOMB, BALL, &CollisionSystem::BombHits);
         }
 
-        void checkForCollisions(World *world)
+        // Returns the collision matrix, "setCollisionMatrix" should be called to change it
+        const CollisionMatrix &getCollisionMatrix() const { return matrix; }
+
+        void setCollisionMatrix(const CollisionMatrix &newMatrix)
         {
-            unordered_set<Entity *> entities = world->getEntities();
-            vector<RigidBodyComponent *> rigidBodies;
-            for (Entity *entity : entities)
-            {
-                RigidBodyComponent *rigidBody = entity->getComponent<RigidBodyComponent>();
-                if (rigidBody == nullptr)
-                    continue;
-                rigidBodies.push_back(rigidBody);
-            }
-            for (unsigned int i = 0; i < rigidBodies.size(); i++)
+            matrix = newMatrix;
+            broadphase.invalidate(); // the masks of the bodies are read from the matrix when the broadphase is rebuilt
+        }
+
+        // Tests the broadphase pairs of a block and stores the contacts it finds in the block
+        // It only reads the colliders and writes to the block, so many blocks can be tested at the same time
+        void testBlock(NarrowphaseBlock &block, size_t begin)
+        {
+            const auto &overlaps = broadphase.getOverlaps();
+            size_t count = std::min(BLOCK_SIZE, overlaps.size() - begin);
+
+            // The pairs that involve a sphere are dispatched on their body types, the box-box pairs are tested in batches
+            block.results.resize(count);
+            block.boxPairs.clear();
+            block.boxPairIndices.clear();
+            for (uint32_t index = 0; index < count; index++)
             {
-                bool iIsBall = rigidBodies[i]->tag == BALL;
-                bool iIsCar = rigidBodies[i]->tag == CAR;
-                bool iIsWall = rigidBodies[i]->tag == WALL;
-                bool iIsGround = rigidBodies[i]->tag == GROUND;
-                bool iIsGoal = rigidBodies[i]->tag == GOAL;
-                bool iIsObstacle = rigidBodies[i]->tag == NONE; // TODO: change this to obstacle
-                bool iIsBomb = rigidBodies[i]->tag == BOMB;
-
-                for (unsigned int j = i + 1; j < rigidBodies.size(); j++)
+                auto [first, second] = overlaps[begin + index];
+                if (colliders[first].type == CUBE && colliders[second].type == CUBE)
                 {
-                    bool isBall = iIsBall || rigidBodies[j]->tag == BALL;
-                    bool isCar = iIsCar || rigidBodies[j]->tag == CAR;
-                    bool isWall = iIsWall || rigidBodies[j]->tag == WALL;
-                    bool isGround = iIsGround || rigidBodies[j]->tag == GROUND;
-                    bool isGoal = iIsGoal || rigidBodies[j]->tag == GOAL;
-                    bool isObstacle = iIsObstacle || rigidBodies[j]->tag == NONE; // TODO: change this to obstacle
-                    bool isBomb = iIsBomb || rigidBodies[j]->tag == BOMB;
-
-                    if (isBall && isCar)
-                        CarHitsBall(rigidBodies[i], rigidBodies[j]);
-                    if (isBall && isWall)
-                        BallHitsWall(rigidBodies[i], rigidBodies[j]);
-                    if (isCar && isWall)
-                        CarHitsWall(rigidBodies[i], rigidBodies[j]);
-                    if (isGoal && isBall)
-                        VarCheckPossibleGoal(rigidBodies[i], rigidBodies[j]);
+                    block.boxPairs.push_back({boxIndices[first], boxIndices[second]});
+                    block.boxPairIndices.push_back(index);
                 }
+                else
+                    block.results[index] = collide(colliders[first], colliders[second]);
             }
-        }
+            block.boxResults.resize(block.boxPairs.size());
+            testOBBPairs(boxes.data(), block.boxPairs.data(), block.boxPairs.size(), block.boxResults.data());
+            for (size_t index = 0; index < block.boxPairs.size(); index++)
+                block.results[block.boxPairIndices[index]] = block.boxResults[index];
 
-        bool checkForBombCollision(World *world)
-        {
-            bool carHitsBombCheck = false;
-            bool ballHitsBombCheck = false;
-            unordered_set<Entity *> entities = world->getEntities();
-            vector<RigidBodyComponent *> rigidBodies;
-            for (Entity *entity : entities)
+            block.contacts.clear();
+            for (size_t index = 0; index < count; index++)
             {
-                RigidBodyComponent *rigidBody = entity->getComponent<RigidBodyComponent>();
-                if (rigidBody == nullptr)
+                const CollisionResult &result = block.results[index];
+                if (!result.collided)
                     continue;
-                rigidBodies.push_back(rigidBody);
+                RigidBodyComponent *first = broadphase.getBody(overlaps[begin + index].first);
+                RigidBodyComponent *second = broadphase.getBody(overlaps[begin + index].second);
+                block.contacts.push_back({first, second, first->tag, second->tag, result.normal, result.penetration});
             }
-            for (unsigned int i = 0; i < rigidBodies.size(); i++)
+        }
+
+        // Finds all the contacts of this tick (a single narrowphase pass over the broadphase pairs)
+        // then solves the solid contacts with impulses and records the events (goal, bomb and ball hits)
+        void update(World *world, float deltaTime)
+        {
+            const auto &overlaps = broadphase.update(world, matrix);
+
+            // The shape of every body is built once, the static bodies are baked when the bodies change
+            // and the sleeping bodies keep the shape they had when they fell asleep
+            // The broadphase already refreshed the world matrices of these bodies, so the parallel tasks only read them
+            bool bake = collidersRebuildCount != broadphase.getRebuildCount() || colliders.size() != broadphase.getProxyCount();
+            collidersRebuildCount = broadphase.getRebuildCount();
+            colliders.resize(broadphase.getProxyCount());
+            ThreadPool *pool = ThreadPool::getInstance();
+            pool->parallelFor(colliders.size(), COLLIDER_GRAIN_SIZE, [this, bake](size_t first, size_t last)
+                              {
+                for (size_t index = first; index < last; index++)
+                    if (bake || !broadphase.isResting((uint32_t)index))
+                        colliders[index] = Collider::fromRigidBody(broadphase.getBody((uint32_t)index)); });
+            boxes.clear();
+            boxIndices.resize(colliders.size());
+            for (uint32_t index = 0; index < colliders.size(); index++)
             {
-                bool iIsBall = rigidBodies[i]->tag == BALL;
-                bool iIsCar = rigidBodies[i]->tag == CAR;
-                bool iIsWall = rigidBodies[i]->tag == WALL;
-                bool iIsGround = rigidBodies[i]->tag == GROUND;
-                bool iIsGoal = rigidBodies[i]->tag == GOAL;
-                bool iIsObstacle = rigidBodies[i]->tag == NONE; // TODO: change this to obstacle
-                bool iIsBomb = rigidBodies[i]->tag == BOMB;
-
-                for (unsigned int j = i + 1; j < rigidBodies.size(); j++)
+                if (colliders[index].type == CUBE)
                 {
-                    bool isBall = iIsBall || rigidBodies[j]->tag == BALL;
-                    bool isCar = iIsCar || rigidBodies[j]->tag == CAR;
-                    bool isWall = iIsWall || rigidBodies[j]->tag == WALL;
-                    bool isGround = iIsGround || rigidBodies[j]->tag == GROUND;
-                    bool isGoal = iIsGoal || rigidBodies[j]->tag == GOAL;
-                    bool isObstacle = iIsObstacle || rigidBodies[j]->tag == NONE; // TODO: change this to obstacle
-                    bool isBomb = iIsBomb || rigidBodies[j]->tag == BOMB;
-
-                    if (isBomb && isCar)
-                        if (CarHitsBomb(rigidBodies[i], rigidBodies[j]))
-                        {
-                            carHitsBombCheck = true;
-                            break;
-                        }
-                    if (isBomb && isBall)
-                        if (BallHitsBomb(rigidBodies[i], rigidBodies[j]))
-                        {
-                            ballHitsBombCheck = true;
-                            break;
-                        }
-                }
-                if (carHitsBombCheck || ballHitsBombCheck)
-                {
-                    break;
+                    boxIndices[index] = (uint32_t)boxes.size();
+                    boxes.push_back(colliders[index].box);
                 }
             }
-            return (carHitsBombCheck || ballHitsBombCheck);
-        }
 
-        bool checkForGoal(World *world)
-        {
-            bool goalCheck = false;
-            unordered_set<Entity *> entities = world->getEntities();
-            vector<RigidBodyComponent *> rigidBodies;
-            for (Entity *entity : entities)
+            size_t blockCount = (overlaps.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            if (blocks.size() < blockCount)
+                blocks.resize(blockCount);
+            pool->parallelFor(blockCount, 1, [this](size_t first, size_t last)
+                              {
+                for (size_t block = first; block < last; block++)
+                    testBlock(blocks[block], block * BLOCK_SIZE); });
+
+            contacts.clear();
+            for (size_t block = 0; block < blockCount; block++)
+                contacts.insert(contacts.end(), blocks[block].contacts.begin(), blocks[block].contacts.end());
+
+            solidContacts.clear();
+            for (const Contact &contact : contacts)
             {
-                RigidBodyComponent *rigidBody = entity->getComponent<RigidBodyComponent>();
-                if (rigidBody == nullptr)
-                    continue;
-                rigidBodies.push_back(rigidBody);
+                wakeUpTouched(contact);
+                if (matrix.isSolid(contact.firstTag, contact.secondTag))
+                    solidContacts.push_back(&contact);
             }
-            for (unsigned int i = 0; i < rigidBodies.size(); i++)
+            solver.solve(solidContacts, deltaTime);
+
+            goalScored = bombHit = ballHit = false;
+            for (const Contact &contact : contacts)
+                if (ContactHandler handler = handlers[contact.firstTag][contact.secondTag])
+                    (this->*handler)(contact);
+
+            // the continuous bodies will be swept from here after they move
+            sweepStarts.clear();
+            for (uint32_t index = 0; index < colliders.size(); index++)
             {
-                bool iIsBall = rigidBodies[i]->tag == BALL;
-                bool iIsCar = rigidBodies[i]->tag == CAR;
-                bool iIsWall = rigidBodies[i]->tag == WALL;
-                bool iIsGround = rigidBodies[i]->tag == GROUND;
-                bool iIsGoal = rigidBodies[i]->tag == GOAL;
-                bool iIsObstacle = rigidBodies[i]->tag == NONE; // TODO: change this to obstacle
-                bool iIsBomb = rigidBodies[i]->tag == BOMB;
-
-                for (unsigned int j = i + 1; j < rigidBodies.size(); j++)
-                {
-                    bool isBall = iIsBall || rigidBodies[j]->tag == BALL;
-                    bool isCar = iIsCar || rigidBodies[j]->tag == CAR;
-                    bool isWall = iIsWall || rigidBodies[j]->tag == WALL;
-                    bool isGround = iIsGround || rigidBodies[j]->tag == GROUND;
-                    bool isGoal = iIsGoal || rigidBodies[j]->tag == GOAL;
-                    bool isObstacle = iIsObstacle || rigidBodies[j]->tag == NONE; // TODO: change this to obstacle
-                    bool isBomb = iIsBomb || rigidBodies[j]->tag == BOMB;
-
-                    if (isGoal && isBall)
-                        if (VarCheckPossibleGoal(rigidBodies[i], rigidBodies[j]))
-                        {
-                            goalCheck = true;
-                            break;
-                        }
-                }
-                if (goalCheck)
-                {
-                    break;
-                }
+                RigidBodyComponent *body = broadphase.getBody(index);
+                if (body->continuous && !broadphase.isResting(index))
+                    sweepStarts.push_back({body, colliders[index].type == SPHERE ? colliders[index].sphere.center : colliders[index].box.center});
             }
-            return (goalCheck);
         }
 
-        bool checkForBallCollision(World *world)
+        // Sweeps the continuous bodies from where they were at the last update to where they are now (it should run after the movement)
+        // A body that passed through a wall or a goal in the tick is moved back to the time of impact, so the contact is found in the next tick
+        // Only the bodies that moved far enough to tunnel are swept, the others are left to the discrete test
+        void sweepContinuousBodies(World *world)
         {
-            bool ballHitsCar = false;
-            unordered_set<Entity *> entities = world->getEntities();
-            vector<RigidBodyComponent *> rigidBodies;
-            for (Entity *entity : entities)
+            PhysicsQueries *queries = world->getPhysicsQueries();
+            if (queries == nullptr)
+                return;
+
+            QueryFilter filter;
+            filter.tagMask = tagBit(WALL) | tagBit(GOAL);
+            for (auto [body, start] : sweepStarts)
             {
-                RigidBodyComponent *rigidBody = entity->getComponent<RigidBodyComponent>();
-                if (rigidBody == nullptr)
+                Entity *owner = body->getOwner();
+                Collider collider = Collider::fromRigidBody(body);
+                vec3 end = collider.type == SPHERE ? collider.sphere.center : collider.box.center;
+                // a box is swept as its inscribed sphere
+                float radius = collider.type == SPHERE ? collider.sphere.radius : min(collider.box.halfExtents.x, min(collider.box.halfExtents.y, collider.box.halfExtents.z));
+
+                vec3 motion = end - start;
+                float distance = glm::length(motion);
+                if (distance <= radius * SWEEP_THRESHOLD)
                     continue;
-                rigidBodies.push_back(rigidBody);
-            }
-            for (unsigned int i = 0; i < rigidBodies.size(); i++)
-            {
-                bool iIsBall = rigidBodies[i]->tag == BALL;
-                bool iIsCar = rigidBodies[i]->tag == CAR;
-                bool iIsWall = rigidBodies[i]->tag == WALL;
-                bool iIsGround = rigidBodies[i]->tag == GROUND;
-                bool iIsGoal = rigidBodies[i]->tag == GOAL;
-                bool iIsObstacle = rigidBodies[i]->tag == NONE; // TODO: change this to obstacle
-                bool iIsBomb = rigidBodies[i]->tag == BOMB;
-
-                for (unsigned int j = i + 1; j < rigidBodies.size(); j++)
-                {
-                    bool isBall = iIsBall || rigidBodies[j]->tag == BALL;
-                    bool isCar = iIsCar || rigidBodies[j]->tag == CAR;
-                    bool isWall = iIsWall || rigidBodies[j]->tag == WALL;
-                    bool isGround = iIsGround || rigidBodies[j]->tag == GROUND;
-                    bool isGoal = iIsGoal || rigidBodies[j]->tag == GOAL;
-                    bool isObstacle = iIsObstacle || rigidBodies[j]->tag == NONE; // TODO: change this to obstacle
-                    bool isBomb = iIsBomb || rigidBodies[j]->tag == BOMB;
-
-                    if (isCar && isBall)
-                        if (CarHitsBall(rigidBodies[i], rigidBodies[j]))
-                        {
-                            ballHitsCar = true;
-                            break;
-                        }
-                }
-                if (ballHitsCar)
-                {
-                    break;
-                }
+
+                vec3 direction = motion / distance;
+                QueryHit hit;
+                filter.ignore = owner;
+                if (!queries->sphereCast(start, radius, direction, distance, hit, filter))
+                    continue;
+
+                // move the body back from the end of the motion to the time of impact
+                vec3 correction = -direction * max(distance - hit.distance - SWEEP_SKIN, 0.0f);
+                if (owner->parent != nullptr)
+                    correction = glm::transpose(owner->parent->getLocalToWorldInverseTranspose()) * vec4(correction, 0.0f);
+                owner->localTransform.position += correction;
             }
-            return ballHitsCar;
         }
+
+        // This should be called after the world is restored (e.g. when a level is reset)
+        // The impulses of the last tick are forgotten and the shapes of the resting bodies are built again, since the restore may have moved them
+        void reset()
+        {
+            solver.reset();
+            broadphase.invalidate();
+        }
+
+        // Returns the contacts found by the last update
+        const vector<Contact> &getContacts() const { return contacts; }
+
+        // Returns true if the ball entered a goal in the last update
+        bool checkForGoal() const { return goalScored; }
+
+        // Returns true if a bomb hit the car or the ball in the last update
+        bool checkForBombCollision() const { return bombHit; }
+
+        // Returns true if a car hit the ball in the last update
+        bool checkForBallCollision() const { return ballHit; }
     };
 
-}
\ No newline at end of file
+}
@@ -3,7 +3,9 @@
 #include "../components/ball-component.hpp"
 #include "../components/movement.hpp"
 #include "../texture/texture-utils.hpp"
+#include "../memory/frame-allocator.hpp"
 #include <GLFW/glfw3.h>
+#include <cstddef>
 #include <vector>
 
 #define ANGLETHRESHOLD 1
@@ -19,6 +21,12 @@ namespace our
         animationSpeed = 1.0f;
         startTime = std::chrono::steady_clock::now();
 
+        // The light buffer is allocated once with room for the maximum number of lights
+        glGenBuffers(1, &lightBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, lightBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
         // Then we check if there is a sky texture in the configuration
         if (config.contains("sky"))
         {
@@ -106,6 +114,9 @@ namespace our
 
     void ForwardRenderer::destroy()
     {
+        glDeleteBuffers(1, &lightBuffer);
+        lightBuffer = 0;
+
         // Delete all objects related to the sky
         if (skyMaterial)
         {
@@ -119,6 +130,7 @@ namespace our
         if (postprocessMaterial)
         {
             glDeleteFramebuffers(1, &postprocessFrameBuffer);
+            GLStateTracker::getInstance()->forgetVertexArray(postProcessVertexArray);
             glDeleteVertexArrays(1, &postProcessVertexArray);
             delete colorTarget;
             delete depthTarget;
@@ -128,6 +140,32 @@ namespace our
         }
     }
 
+    void ForwardRenderer::uploadLights(World *world)
+    {
+        const auto &lights = world->getComponents<LightComponent>();
+        // NOTE: the lights after the first MAX_LIGHTS are ignored (as they were by the shaders)
+        int count = (int)std::min(lights.size(), (size_t)LightBlock::MAX_LIGHTS);
+        lightBlock.lightCount = count;
+        for (int index = 0; index < count; index++)
+        {
+            const LightComponent *light = lights[index];
+            LightData &data = lightBlock.lights[index];
+            data.direction = light->direction;
+            data.lightType = light->lightType;
+            data.position = glm::vec3(light->getOwner()->getLocalToWorldMatrix() * glm::vec4(light->getOwner()->localTransform.position, 1.0));
+            data.intensity = light->intensity;
+            data.color = light->color;
+            data.attenuation = light->attenuation;
+            data.coneAngles = light->coneAngles;
+        }
+
+        // Only the used part of the block is uploaded
+        glBindBuffer(GL_UNIFORM_BUFFER, lightBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, offsetof(LightBlock, lights) + count * sizeof(LightData), &lightBlock);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, LightBlock::BINDING, lightBuffer);
+    }
+
     void ForwardRenderer::render(World *world)
     {
         // First of all, we search for a camera and for all the mesh renderers
@@ -135,49 +173,44 @@ namespace our
         CameraComponent *camera = nullptr;
         opaqueCommands.clear();
         transparentCommands.clear();
-        lightsSources.clear();
-        std::vector<BallCommand> ballModels;
-        for (auto entity : world->getEntities())
-        {
-            // If we hadn't found a camera yet, we look for a camera in this entity
-            if (!camera)
-                camera = entity->getComponent<CameraComponent>();
-            // If this entity has a mesh renderer component
+        // The ball commands only live during this frame, so they are allocated from the frame arena
+        FrameVector<BallCommand> ballModels;
 
-            if (auto meshRenderer = entity->getComponent<MeshRendererComponent>(); meshRenderer)
+        // We use the first camera in the world (if any)
+        if (const auto &cameras = world->getComponents<CameraComponent>(); !cameras.empty())
+            camera = cameras.front();
+
+        for (auto meshRenderer : world->getComponents<MeshRendererComponent>())
+        {
+            Entity *entity = meshRenderer->getOwner();
+            // We construct a command from it
+            RenderCommand command;
+            // The render matrix is interpolated between the last two simulation steps
+            command.localToWorld = entity->getRenderMatrix();
+            command.localToWorldInverseTranspose = entity->getRenderInverseTranspose();
+            command.center = glm::vec3(command.localToWorld * glm::vec4(0, 0, 0, 1));
+            command.mesh = meshRenderer->mesh;
+            command.material = meshRenderer->material;
+
+            // if it is transparent, we add it to the transparent commands list
+            if (entity->parent && entity->parent->getComponent<BallComponent>() != nullptr)
             {
-                // We construct a command from it
-                RenderCommand command;
-                command.localToWorld = meshRenderer->getOwner()->getLocalToWorldMatrix();
-                command.center = glm::vec3(command.localToWorld * glm::vec4(0, 0, 0, 1));
-                command.mesh = meshRenderer->mesh;
-                command.material = meshRenderer->material;
-
-                // if it is transparent, we add it to the transparent commands list
-                if (entity->parent && entity->parent->getComponent<BallComponent>() != nullptr)
-                {
-                    BallCommand ballCommand;
-                    MovementComponent *movement = entity->parent->getComponent<MovementComponent>();
-                    ballCommand.angle = movement->current_angle.x;
-                    ballCommand.center = command.center, ballCommand.localToWorld = command.localToWorld, ballCommand.mesh = command.mesh, ballCommand.material = command.material;
-                    ballCommand.direction = movement->forward;
-                    ballCommand.filled = true;
-                    ballModels.push_back(ballCommand);
-                }
-                else if (command.material->transparent)
-                {
-                    transparentCommands.push_back(command);
-                }
-                else
-                {
-                    // Otherwise, we add it to the opaque command list
-                    opaqueCommands.push_back(command);
-                }
+                BallCommand ballCommand;
+                MovementComponent *movement = entity->parent->getComponent<MovementComponent>();
+                ballCommand.angle = movement->current_angle.x;
+                ballCommand.center = command.center, ballCommand.localToWorld = command.localToWorld, ballCommand.localToWorldInverseTranspose = command.localToWorldInverseTranspose, ballCommand.mesh = command.mesh, ballCommand.material = command.material;
+                ballCommand.direction = movement->forward;
+                ballCommand.filled = true;
+                ballModels.push_back(ballCommand);
             }
-
-            if (auto lightSource = entity->getComponent<LightComponent>(); lightSource)
+            else if (command.material->transparent)
+            {
+                transparentCommands.push_back(command);
+            }
+            else
             {
-                lightsSources.push_back(lightSource);
+                // Otherwise, we add it to the opaque command list
+                opaqueCommands.push_back(command);
             }
         }
 
@@ -185,6 +218,8 @@ namespace our
         if (camera == nullptr)
             return;
 
+        uploadLights(world);
+
         // TODO: (Req 9) Modify the following line such that "cameraForward" contains a vector pointing the camera forward direction
         //  HINT: See how you wrote the CameraComponent::getViewMatrix, it should help you solve this one
         // glm::mat4 Matrix = camera->getOwner()->getLocalToWorldMatrix();
@@ -208,8 +243,9 @@ namespace our
         glViewport(0, 0, this->windowSize.x, this->windowSize.y);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClearDepth(1.0);
-        glColorMask(1, 1, 1, 1);
-        glDepthMask(1);
+        // The masks go through the state tracker since the pipeline states of the materials change them too
+        GLStateTracker::getInstance()->setColorMask(glm::bvec4(true));
+        GLStateTracker::getInstance()->setDepthMask(true);
 
         // If there is a postprocess material, bind the framebuffer
         if (postprocessMaterial)
@@ -229,25 +265,13 @@ namespace our
         for (BallCommand ballCommand : ballModels)
         {
             ballCommand.material->setup();
-            ballCommand.material->shader->set("transform", view_projection * ballCommand.localToWorld);
-            ballCommand.material->shader->set("axis", ballCommand.direction);
-            ballCommand.material->shader->set("angle", ballCommand.angle);
-            ballCommand.material->shader->set("M", ballCommand.localToWorld);
-            ballCommand.material->shader->set("M_IT", glm::transpose(glm::inverse(ballCommand.localToWorld)));
-            ballCommand.material->shader->set("cameraPos", ballCommand.center);
-            int index = 0;
-            for (auto it = lightsSources.begin(); it != lightsSources.end(); it++, index++)
-            {
-                ballCommand.material->shader->set("lights[" + std::to_string(index) + "].lightType", (*it)->lightType);
-                ballCommand.material->shader->set("lights[" + std::to_string(index) + "].direction", (*it)->direction);
-                ballCommand.material->shader->set("lights[" + std::to_string(index) + "].color", (*it)->color);
-                auto lightPosition = glm::vec3((*it)->getOwner()->getLocalToWorldMatrix() * glm::vec4((*it)->getOwner()->localTransform.position, 1.0));
-                ballCommand.material->shader->set("lights[" + std::to_string(index) + "].position", lightPosition);
-                ballCommand.material->shader->set("lights[" + std::to_string(index) + "].coneAngles", (*it)->coneAngles);
-                ballCommand.material->shader->set("lights[" + std::to_string(index) + "].attenuation", (*it)->attenuation);
-                ballCommand.material->shader->set("lights[" + std::to_string(index) + "].intensity", (*it)->intensity);
-            }
-            ballCommand.material->shader->set("lightCount", (int)lightsSources.size());
+            ballCommand.material->shader->set(transformId, view_projection * ballCommand.localToWorld);
+            ballCommand.material->shader->set(axisId, ballCommand.direction);
+            ballCommand.material->shader->set(angleId, ballCommand.angle);
+            ballCommand.material->shader->set(modelId, ballCommand.localToWorld);
+            ballCommand.material->shader->set(modelInverseTransposeId, ballCommand.localToWorldInverseTranspose);
+            ballCommand.material->shader->set(cameraPositionId, ballCommand.center);
+            ballCommand.material->shader->bindUniformBlock(lightsBlockId, LightBlock::BINDING);
             ballCommand.mesh->draw();
         }
 
@@ -255,25 +279,13 @@ namespace our
         for (our::RenderCommand &command : opaqueCommands)
         {
             command.material->setup();
-            command.material->shader->set("transform", view_projection * command.localToWorld);
-            if (dynamic_cast<LitMaterial *>(command.material) || dynamic_cast<LitTexturedMaterial *>(command.material))
+            command.material->shader->set(transformId, view_projection * command.localToWorld);
+            if (command.material->isLit())
             {
-                command.material->shader->set("M", command.localToWorld);
-                command.material->shader->set("M_IT", glm::transpose(glm::inverse(command.localToWorld)));
-                command.material->shader->set("cameraPos", command.center);
-                int index = 0;
-                for (auto it = lightsSources.begin(); it != lightsSources.end(); it++, index++)
-                {
-                    command.material->shader->set("lights[" + std::to_string(index) + "].lightType", (*it)->lightType);
-                    command.material->shader->set("lights[" + std::to_string(index) + "].direction", (*it)->direction);
-                    command.material->shader->set("lights[" + std::to_string(index) + "].color", (*it)->color);
-                    auto lightPosition = glm::vec3((*it)->getOwner()->getLocalToWorldMatrix() * glm::vec4((*it)->getOwner()->localTransform.position, 1.0));
-                    command.material->shader->set("lights[" + std::to_string(index) + "].position", lightPosition);
-                    command.material->shader->set("lights[" + std::to_string(index) + "].coneAngles", (*it)->coneAngles);
-                    command.material->shader->set("lights[" + std::to_string(index) + "].attenuation", (*it)->attenuation);
-                    command.material->shader->set("lights[" + std::to_string(index) + "].intensity", (*it)->intensity);
-                }
-                command.material->shader->set("lightCount", (int)lightsSources.size());
+                command.material->shader->set(modelId, command.localToWorld);
+                command.material->shader->set(modelInverseTransposeId, command.localToWorldInverseTranspose);
+                command.material->shader->set(cameraPositionId, command.center);
+                command.material->shader->bindUniformBlock(lightsBlockId, LightBlock::BINDING);
             }
             command.mesh->draw();
         }
@@ -293,7 +305,7 @@ namespace our
                 0.0f, 0.0f, 0.0f, 0.0f,
                 0.0f, 0.0f, 1.0f, 1.0f);
 
-            skyMaterial->shader->set("transform", alwaysBehindTransform * view_projection * sky_model);
+            skyMaterial->shader->set(transformId, alwaysBehindTransform * view_projection * sky_model);
             skySphere->draw();
         }
         // TODO: (Req 9) Draw all the transparent commands
@@ -301,26 +313,14 @@ namespace our
         for (our::RenderCommand &command : transparentCommands)
         {
             command.material->setup();
-            command.material->shader->set("transform", view_projection * command.localToWorld);
+            command.material->shader->set(transformId, view_projection * command.localToWorld);
 
-            if (dynamic_cast<LitMaterial *>(command.material) || dynamic_cast<LitTexturedMaterial *>(command.material))
+            if (command.material->isLit())
             {
-                command.material->shader->set("M", command.localToWorld);
-                command.material->shader->set("M_IT", glm::transpose(glm::inverse(command.localToWorld)));
-                command.material->shader->set("cameraPos", command.center);
-                int index = 0;
-                for (auto it = lightsSources.begin(); it != lightsSources.end(); it++, index++)
-                {
-                    command.material->shader->set("lights[" + std::to_string(index) + "].lightType", (*it)->lightType);
-                    command.material->shader->set("lights[" + std::to_string(index) + "].direction", (*it)->direction);
-                    command.material->shader->set("lights[" + std::to_string(index) + "].color", (*it)->color);
-                    auto lightPosition = glm::vec3((*it)->getOwner()->getLocalToWorldMatrix() * glm::vec4((*it)->getOwner()->localTransform.position, 1.0));
-                    command.material->shader->set("lights[" + std::to_string(index) + "].position", lightPosition);
-                    command.material->shader->set("lights[" + std::to_string(index) + "].coneAngles", (*it)->coneAngles);
-                    command.material->shader->set("lights[" + std::to_string(index) + "].attenuation", (*it)->attenuation);
-                    command.material->shader->set("lights[" + std::to_string(index) + "].intensity", (*it)->intensity);
-                }
-                command.material->shader->set("lightCount", (int)lightsSources.size());
+                command.material->shader->set(modelId, command.localToWorld);
+                command.material->shader->set(modelInverseTransposeId, command.localToWorldInverseTranspose);
+                command.material->shader->set(cameraPositionId, command.center);
+                command.material->shader->bindUniformBlock(lightsBlockId, LightBlock::BINDING);
             }
             command.mesh->draw();
         }
@@ -331,7 +331,7 @@ namespace our
             glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
             // TODO: (Req 11) Setup the postprocess material and draw the fullscreen triangle
             postprocessMaterial->setup();
-            glBindVertexArray(this->postProcessVertexArray);
+            GLStateTracker::getInstance()->bindVertexArray(this->postProcessVertexArray);
 
             glDrawArrays(GL_TRIANGLES, 0, 3);
         }
@@ -9,6 +9,7 @@
 #include <glad/gl.h>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
 
 namespace our
 {
@@ -19,11 +20,38 @@ namespace our
     struct RenderCommand
     {
         glm::mat4 localToWorld;
+        glm::mat4 localToWorldInverseTranspose;
         glm::vec3 center;
         Mesh *mesh;
         Material *material;
     };
 
+    // The data of one light in the "Lights" uniform block of the lit shaders (std140 layout, 80 bytes per light)
+    struct LightData
+    {
+        glm::vec3 direction;
+        int32_t lightType;
+        glm::vec3 position; // In the world space
+        float intensity;
+        glm::vec3 color;
+        float padding0;
+        glm::vec3 attenuation;
+        float padding1;
+        glm::vec2 coneAngles;
+        glm::vec2 padding2;
+    };
+    static_assert(sizeof(LightData) == 80, "LightData must match the std140 layout of the Light struct");
+
+    // The "Lights" uniform block of the lit shaders
+    struct LightBlock
+    {
+        static constexpr int MAX_LIGHTS = 100;  // Must match MAX_LIGHTS in lit.frag and lit-texture.frag
+        static constexpr GLuint BINDING = 0; // The uniform buffer binding point of the block
+        int32_t lightCount;
+        int32_t padding[3]; // The array starts at a multiple of 16 bytes
+        LightData lights[MAX_LIGHTS];
+    };
+
     struct BallCommand : public RenderCommand
     {
         bool filled = false;
@@ -43,8 +71,6 @@ namespace our
         // We define them here (instead of being local to the "render" function) as an optimization to prevent reallocating them every frame
         std::vector<RenderCommand> opaqueCommands;
         std::vector<RenderCommand> transparentCommands;
-        // light List
-        std::vector<LightComponent *> lightsSources;
         // Objects used for rendering a skybox
         Mesh *skySphere;
         TexturedMaterial *skyMaterial;
@@ -53,6 +79,19 @@ namespace our
         Texture2D *colorTarget, *depthTarget;
         TexturedMaterial *postprocessMaterial;
 
+        // The lights are packed once per frame into a uniform buffer (std140) shared by all the lit shaders,
+        // so drawing a lit object sends no light data at all
+        GLuint lightBuffer = 0;
+        LightBlock lightBlock;
+        UniformId lightsBlockId = UniformId("Lights");
+        // The ids of the uniforms set for every draw
+        UniformId transformId = UniformId("transform"), modelId = UniformId("M"), modelInverseTransposeId = UniformId("M_IT");
+        UniformId cameraPositionId = UniformId("cameraPos");
+        UniformId axisId = UniformId("axis"), angleId = UniformId("angle");
+
+        // Packs the lights of the world and uploads them to the light buffer
+        void uploadLights(World *world);
+
         float basePixelSize;  // Starting pixel size
         float animationSpeed; // Speed of the animation
         std::chrono::time_point<std::chrono::steady_clock> startTime;
@@ -33,21 +33,13 @@ namespace our
         void update(World *world, float deltaTime)
         {
             // First of all, we search for an entity containing both a CameraComponent and a FreeCameraControllerComponent
-            // As soon as we find one, we break
-            CameraComponent *camera = nullptr;
-            FreeCameraControllerComponent *controller = nullptr;
-            for (auto entity : world->getEntities())
-            {
-                camera = entity->getComponent<CameraComponent>();
-                controller = entity->getComponent<FreeCameraControllerComponent>();
-                if (camera && controller)
-                    break;
-            }
+            const auto &cameras = world->view<CameraComponent, FreeCameraControllerComponent>();
             // If there is no entity with both a CameraComponent and a FreeCameraControllerComponent, we can do nothing so we return
-            if (!(camera && controller))
+            if (cameras.empty())
                 return;
-            // Get the entity that we found via getOwner of camera (we could use controller->getOwner())
-            Entity *entity = camera->getOwner();
+            Entity *entity = cameras.front();
+            CameraComponent *camera = entity->getComponent<CameraComponent>();
+            FreeCameraControllerComponent *controller = entity->getComponent<FreeCameraControllerComponent>();
 
             // If the left mouse button is pressed, we lock and hide the mouse. This common in First Person Games.
             if (app->getMouse().isPressed(GLFW_MOUSE_BUTTON_1) && !mouse_locked)
@@ -62,9 +54,10 @@ namespace our
                 mouse_locked = false;
             }
 
-            // We get a reference to the entity's position and rotation
+            // We get a reference to the entity's position
+            // The camera turns with a quaternion, so it can look straight up or down without a gimbal lock (and without clamping the pitch)
             glm::vec3 &position = entity->localTransform.position;
-            glm::vec3 &rotation = entity->localTransform.rotation;
+            entity->localTransform.useQuaternion = true;
 
             // TODO: we may edit this part later
 
@@ -73,21 +66,13 @@ namespace our
             if (app->getMouse().isPressed(GLFW_MOUSE_BUTTON_1))
             {
                 glm::vec2 delta = app->getMouse().getMouseDelta();
-                rotation.x -= delta.y * controller->rotationSensitivity; // The y-axis controls the pitch
-                rotation.y -= delta.x * controller->rotationSensitivity; // The x-axis controls the yaw
+                float pitch = -delta.y * controller->rotationSensitivity; // The y-axis controls the pitch (around the camera right)
+                float yaw = -delta.x * controller->rotationSensitivity;   // The x-axis controls the yaw (around the world up)
+                glm::quat orientation = entity->localTransform.getOrientation();
+                orientation = glm::angleAxis(yaw, glm::vec3(0, 1, 0)) * orientation * glm::angleAxis(pitch, glm::vec3(1, 0, 0));
+                entity->localTransform.setOrientation(orientation);
             }
 
-            // TODO: we better move this to a config file
-
-            // We prevent the pitch from exceeding a certain angle from the XZ plane to prevent gimbal locks
-            if (rotation.x < -glm::half_pi<float>() * 0.99f)
-                rotation.x = -glm::half_pi<float>() * 0.99f;
-            if (rotation.x > glm::half_pi<float>() * 0.99f)
-                rotation.x = glm::half_pi<float>() * 0.99f;
-            // This is not necessary, but whenever the rotation goes outside the 0 to 2*PI range, we wrap it back inside.
-            // This could prevent floating point error if the player rotates in single direction for an extremely long time.
-            rotation.y = glm::wrapAngle(rotation.y);
-
             // We update the camera fov based on the mouse wheel scrolling amount
             float fov = camera->fovY + app->getMouse().getScrollOffset().y * controller->fovSensitivity;
             fov = glm::clamp(fov, glm::pi<float>() * 0.01f, glm::pi<float>() * 0.99f); // We keep the fov in the range 0.01*PI to 0.99*PI
@@ -4,6 +4,9 @@
 #include "../components/movement.hpp"
 #include "../components/ball-component.hpp"
 #include "../ecs/transform.hpp"
+#include "simd.hpp"
+#include <cstdint>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <glm/trigonometric.hpp>
@@ -16,68 +19,291 @@ using std::max;
 namespace our
 {
 
+    // The bodies of one kind that are integrated together by the movement kernel, in structure of arrays form
+    // The members of a batch are kept across ticks and only change when the world entities change.
+    // The parameters that are only set when a body is loaded are copied once, while the state that the other systems
+    // (and the world snapshots) change between ticks is loaded every tick for the members that the kernel moves
+    struct MovementBatch
+    {
+        std::vector<MovementComponent *> movements;
+        std::vector<uint8_t> active; // 1 if the body is moved by the kernel in this tick (awake and not in a special movement mode)
+        std::vector<float> positionX, positionY, positionZ;
+        std::vector<float> directionX, directionY, directionZ; // The forward vector rotated by the body rotation
+        std::vector<float> rotationX, rotationY, rotationZ;
+        std::vector<float> velocity, minVelocity, maxVelocity, slowdown, boost;
+        std::vector<float> angleX, angleY, angleZ;
+        std::vector<float> angularX, angularY, angularZ, maxAngular;
+
+        size_t size() const { return movements.size(); }
+
+        // Replaces the members of the batch
+        void assign(const std::vector<MovementComponent *> &members)
+        {
+            movements = members;
+            active.assign(members.size(), 0);
+            for (auto *array : {&positionX, &positionY, &positionZ, &directionX, &directionY, &directionZ, &rotationX, &rotationY, &rotationZ,
+                                &velocity, &minVelocity, &maxVelocity, &slowdown, &boost, &angleX, &angleY, &angleZ,
+                                &angularX, &angularY, &angularZ, &maxAngular})
+                array->assign(members.size(), 0.0f);
+            for (size_t index = 0; index < members.size(); index++)
+            {
+                minVelocity[index] = members[index]->min_velocity;
+                slowdown[index] = members[index]->slowdownFactor;
+                maxAngular[index] = members[index]->max_angular_velocity;
+            }
+        }
+
+        // Copies the current state of a member before the kernel moves it
+        void load(size_t index)
+        {
+            MovementComponent *movement = movements[index];
+            Transform &transform = movement->getOwner()->localTransform;
+            glm::vec3 direction = transform.convertToLocalSpace(movement->forward);
+            positionX[index] = transform.position.x;
+            positionY[index] = transform.position.y;
+            positionZ[index] = transform.position.z;
+            directionX[index] = direction.x;
+            directionY[index] = direction.y;
+            directionZ[index] = direction.z;
+            rotationX[index] = transform.rotation.x;
+            rotationY[index] = transform.rotation.y;
+            rotationZ[index] = transform.rotation.z;
+            velocity[index] = movement->current_velocity;
+            maxVelocity[index] = movement->max_velocity; // a level may change the top speed of a car
+            boost[index] = movement->boosting ? 1.5f : 1.0f;
+            angleX[index] = movement->current_angle.x;
+            angleY[index] = movement->current_angle.y;
+            angleZ[index] = movement->current_angle.z;
+            angularX[index] = movement->angular_velocity.x;
+            angularY[index] = movement->angular_velocity.y;
+            angularZ[index] = movement->angular_velocity.z;
+        }
+
+        // Copies the integrated state of the active members back to the movement components and the transforms
+        // The kernel also runs over the inactive members (on their stale state), but their results are dropped
+        void writeBack()
+        {
+            for (size_t index = 0; index < movements.size(); index++)
+            {
+                if (!active[index])
+                    continue;
+                MovementComponent *movement = movements[index];
+                Transform &transform = movement->getOwner()->localTransform;
+                transform.position = glm::vec3(positionX[index], positionY[index], positionZ[index]);
+                transform.rotation = glm::vec3(rotationX[index], rotationY[index], rotationZ[index]);
+                movement->current_velocity = velocity[index];
+                movement->current_angle = glm::vec3(angleX[index], angleY[index], angleZ[index]);
+                movement->angular_velocity.x = angularX[index];
+            }
+        }
+    };
+
     // The movement system is responsible for moving every entity which contains a MovementComponent.
     // This system is added as a simple example for how use the ECS framework to implement logic.
     // For more information, see "common/components/movement.hpp"
     class MovementSystem
     {
     private:
+        // The bodies that move along their forward vector without jumping or hitting a wall are integrated by the kernel
+        // They are split into homogeneous batches (rolling or not, spinning or not) so that the kernel has no branches
+        // The other bodies (moved towards a target, jumping, blocked by a wall, stopped for a frame or rotated by a quaternion) are updated one by one
+        MovementBatch batches[4];
+
+        // A moving body with the batch it belongs to and its index in that batch
+        struct Body
+        {
+            MovementComponent *movement;
+            bool isBall; // Balls roll but do not spin
+            int batch;
+            size_t slot;
+        };
+        std::vector<Body> bodies;
+        size_t entitiesVersion = 0; // The version of the world entities when the batches were built
+
+        static int getBatchIndex(bool rolling, bool spinning) { return (rolling ? 2 : 0) | (spinning ? 1 : 0); }
+
+        static bool canBatch(const MovementComponent *movement)
+        {
+            // the kernel adds the spin to the euler angles, so quaternion transforms are rotated by "updateBody"
+            return !movement->getOwner()->localTransform.useQuaternion && !movement->stopMovingOneFrame && !movement->directedMovementMode && !movement->ascending && !movement->descending &&
+                   movement->collidedWallNormal == vec3(0.0, 0.0, 0.0);
+        }
+
         void applyAccelration(MovementComponent *movementComponent, float deltaTime)
         {
             movementComponent->decreaseSpeed(deltaTime);
         }
 
+        // Integrates the bodies starting at the given index of the batch (one with "float", 4 with "Float4")
+        // It does the same steps as "updateBody" for a body that is not directed, jumping or blocked by a wall
+        template <typename Real, bool ROLLING, bool SPINNING>
+        static void integrate(MovementBatch &batch, size_t index, float deltaTime)
+        {
+            using namespace simd;
+            const Real zero = 0.0f, one = 1.0f, minusOne = -1.0f, dt = deltaTime;
+
+            Real velocity, minVelocity, maxVelocity, slowdown, boost, maxAngular;
+            load(velocity, &batch.velocity[index]);
+            load(minVelocity, &batch.minVelocity[index]);
+            load(maxVelocity, &batch.maxVelocity[index]);
+            load(slowdown, &batch.slowdown[index]);
+            load(boost, &batch.boost[index]);
+            load(maxAngular, &batch.maxAngular[index]);
+            Real position[3], direction[3], rotation[3], angle[3], angular[3];
+            float *positions[3] = {&batch.positionX[index], &batch.positionY[index], &batch.positionZ[index]};
+            float *directions[3] = {&batch.directionX[index], &batch.directionY[index], &batch.directionZ[index]};
+            float *rotations[3] = {&batch.rotationX[index], &batch.rotationY[index], &batch.rotationZ[index]};
+            float *angles[3] = {&batch.angleX[index], &batch.angleY[index], &batch.angleZ[index]};
+            float *angulars[3] = {&batch.angularX[index], &batch.angularY[index], &batch.angularZ[index]};
+            for (int c = 0; c < 3; c++)
+            {
+                load(position[c], positions[c]);
+                load(direction[c], directions[c]);
+                load(rotation[c], rotations[c]);
+                load(angle[c], angles[c]);
+                load(angular[c], angulars[c]);
+            }
+
+            // The speed decreases towards 0 then it is clamped (a body at rest stays at rest)
+            auto moving = lessThan(zero, absolute(velocity));
+            Real sign = select(lessThan(zero, velocity), one, select(lessThan(velocity, zero), minusOne, zero));
+            velocity = maximum(absolute(velocity) - slowdown * dt, zero) * sign;
+            if (ROLLING)
+                angular[0] = select(moving, minimum(velocity * 0.8f, maxAngular), angular[0]);
+            velocity = maximum(minimum(velocity, maxVelocity), minVelocity);
+
+            // The angle turns with the direction of the movement
+            sign = select(lessThan(zero, velocity), one, select(lessThan(velocity, zero), minusOne, zero));
+            const Real fullTurn = 360.0f;
+            for (int c = 0; c < 3; c++)
+            {
+                angle[c] = angle[c] + angular[c] * sign * dt;
+                angle[c] = select(lessThan(fullTurn, angle[c]), angle[c] - fullTurn, angle[c]);
+            }
+
+            // The body moves along its direction and stays above the ground
+            Real step = dt * (velocity * boost);
+            for (int c = 0; c < 3; c++)
+                position[c] = position[c] + direction[c] * step;
+            position[1] = maximum(position[1], one);
+
+            // The angular velocity is in degrees per second
+            if (SPINNING)
+            {
+                const Real toRadians = glm::radians(1.0f);
+                for (int c = 0; c < 3; c++)
+                    rotation[c] = rotation[c] + angular[c] * toRadians * dt;
+            }
+
+            store(&batch.velocity[index], velocity);
+            for (int c = 0; c < 3; c++)
+            {
+                store(positions[c], position[c]);
+                store(rotations[c], rotation[c]);
+                store(angles[c], angle[c]);
+                store(angulars[c], angular[c]);
+            }
+        }
+
+        template <bool ROLLING, bool SPINNING>
+        static void integrateBatch(MovementBatch &batch, float deltaTime)
+        {
+            size_t index = 0;
+#ifdef OUR_USE_SSE
+            for (; index + 4 <= batch.size(); index += 4)
+                integrate<simd::Float4, ROLLING, SPINNING>(batch, index, deltaTime);
+#endif
+            for (; index < batch.size(); index++)
+                integrate<float, ROLLING, SPINNING>(batch, index, deltaTime);
+            batch.writeBack();
+        }
+
+        // Moves a single body, every movement mode is handled here
+        void updateBody(MovementComponent *movement, bool isBall, float deltaTime)
+        {
+            Entity *entity = movement->getOwner();
+            if (movement->stopMovingOneFrame)
+            {
+                movement->stopMovingOneFrame = false;
+                return;
+            }
+
+            // Change the position and rotation based on the linear & angular velocity and delta time.
+            applyAccelration(movement, deltaTime);
+            movement->adjustSpeed(0.0f);
+
+            // TODO: move this inside movement
+            if (movement->collidedWallNormal != vec3(0.0, 0.0, 0.0))
+            {
+                vec3 carDirection = entity->localTransform.convertToLocalSpace(movement->forward);
+                carDirection *= movement->current_velocity > 0 ? 1 : -1;
+
+                if (glm::dot(carDirection, movement->collidedWallNormal) < 0)
+                    return;
+
+                movement->collidedWallNormal = vec3(0.0, 0.0, 0.0);
+            }
+
+            movement->updateAngle(deltaTime);
+            movement->updateJumpState(deltaTime);
+
+            if (!movement->directedMovementMode)
+            {
+                float speed =  movement->current_velocity * (movement->boosting ? 1.5f : 1.0f);
+                entity->localTransform.applyLinearVelocity(movement->forward, deltaTime * speed);
+            }
+            else
+            {
+                glm::vec3 target_in_world = movement->targetPointInWorldSpace;
+                glm::vec3 source_in_world = entity->getLocalToWorldCenter();
+                entity->localTransform.moveTowards(target_in_world, source_in_world, deltaTime * movement->max_velocity);
+            }
+
+            if (!isBall)
+                entity->localTransform.applyAngularVelocity(movement->angular_velocity, deltaTime);
+        }
+
     public:
+        // Puts every body in the batch of its kind, this is only done when the world entities change
+        void rebuild(World *world)
+        {
+            std::vector<MovementComponent *> members[4];
+            bodies.clear();
+            for (MovementComponent *movement : world->getComponents<MovementComponent>())
+            {
+                bool isBall = movement->getOwner()->getComponent<BallComponent>() != nullptr;
+                int batch = getBatchIndex(movement->canRoll, !isBall);
+                bodies.push_back({movement, isBall, batch, members[batch].size()});
+                members[batch].push_back(movement);
+            }
+            for (int batch = 0; batch < 4; batch++)
+                batches[batch].assign(members[batch]);
+            entitiesVersion = world->getEntitiesVersion();
+        }
+
         // This should be called every frame to update all entities containing a MovementComponent.
         void update(World *world, float deltaTime)
         {
-            // For each entity in the world
-            for (Entity *entity : world->getEntities())
+            if (world->getEntitiesVersion() != entitiesVersion || world->getComponents<MovementComponent>().size() != bodies.size())
+                rebuild(world);
+
+            for (const Body &body : bodies)
             {
-                // Get the movement component if it exists
-                MovementComponent *movement = entity->getComponent<MovementComponent>();
-                // If the movement component exists
-                if (movement && !movement->stopMovingOneFrame)
-                {
-                    // Change the position and rotation based on the linear & angular velocity and delta time.
-                    applyAccelration(movement, deltaTime);
-                    movement->adjustSpeed(0.0f);
-
-                    // TODO: move this inside movement
-                    if (movement->collidedWallNormal != vec3(0.0, 0.0, 0.0))
-                    {
-                        vec3 carDirection = entity->localTransform.convertToLocalSpace(movement->forward);
-                        carDirection *= movement->current_velocity > 0 ? 1 : -1;
-
-                        if (glm::dot(carDirection, movement->collidedWallNormal) < 0)
-                            continue;
-
-                        movement->collidedWallNormal = vec3(0.0, 0.0, 0.0);
-                    }
-
-                    movement->updateAngle(deltaTime);
-                    movement->updateJumpState(deltaTime);
-
-                    if (!movement->directedMovementMode)
-                    {
-                        float speed =  movement->current_velocity * (movement->boosting ? 1.5 : 1);
-                        entity->localTransform.applyLinearVelocity(movement->forward, deltaTime * speed);
-                    }
-                    else
-                    {
-                        glm::vec3 target_in_world = movement->targetPointInWorldSpace;
-                        glm::vec3 source_in_world = entity->getLocalToWorldCenter();
-                        entity->localTransform.moveTowards(target_in_world, source_in_world, deltaTime * movement->max_velocity);
-                    }
-
-                    if (entity->getComponent<BallComponent>() == nullptr)
-                        entity->localTransform.applyAngularVelocity(movement->angular_velocity);
-                }
-                else if (movement)
-                {
-                    movement->stopMovingOneFrame = false;
-                }
+                MovementComponent *movement = body.movement;
+                // an idle body goes to sleep and is not moved until it gets a velocity again
+                movement->updateSleep();
+                MovementBatch &batch = batches[body.batch];
+                batch.active[body.slot] = !movement->sleeping && canBatch(movement);
+                if (batch.active[body.slot])
+                    batch.load(body.slot);
+                else if (!movement->sleeping)
+                    updateBody(movement, body.isBall, deltaTime);
             }
+
+            integrateBatch<false, false>(batches[getBatchIndex(false, false)], deltaTime);
+            integrateBatch<false, true>(batches[getBatchIndex(false, true)], deltaTime);
+            integrateBatch<true, false>(batches[getBatchIndex(true, false)], deltaTime);
+            integrateBatch<true, true>(batches[getBatchIndex(true, true)], deltaTime);
         }
     };
 
@@ -0,0 +1,322 @@
+#pragma once
+
+#include "aabb.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // A dynamic AABB tree (a bounding volume hierarchy that is updated incrementally)
+    // Every leaf stores a "fat" AABB that is larger than the object it encloses by a margin, so while the object
+    // moves inside its fat AABB, the tree does not change at all. When the object leaves it, only its leaf is reinserted.
+    // After every insertion and removal, the ancestors of the changed leaf are refitted and rotated (like an AVL tree)
+    // to keep the tree balanced, so the queries visit O(log n) nodes instead of scanning every object.
+    class AABBTree
+    {
+    public:
+        static constexpr int32_t NULL_NODE = -1;
+
+    private:
+        // The maximum depth of the stack used to traverse the tree, the balancing keeps the height far below it
+        static constexpr int STACK_SIZE = 256;
+
+        struct Node
+        {
+            AABB box;
+            void *userData = nullptr;
+            int32_t parent = NULL_NODE; // The next free node when the node is in the free list
+            int32_t child1 = NULL_NODE, child2 = NULL_NODE;
+            int32_t height = 0; // Leaves have a height of 0, free nodes have a height of -1
+
+            bool isLeaf() const { return child1 == NULL_NODE; }
+        };
+
+        std::vector<Node> nodes;
+        int32_t root = NULL_NODE;
+        int32_t freeList = NULL_NODE; // The nodes released by removed leaves, they are reused first
+        glm::vec3 margin;            // How much the fat AABBs are larger than the objects
+
+        int32_t allocateNode()
+        {
+            if (freeList == NULL_NODE)
+            {
+                nodes.emplace_back();
+                return (int32_t)nodes.size() - 1;
+            }
+            int32_t node = freeList;
+            freeList = nodes[node].parent;
+            nodes[node] = Node();
+            return node;
+        }
+
+        void freeNode(int32_t node)
+        {
+            nodes[node].parent = freeList;
+            nodes[node].height = -1;
+            freeList = node;
+        }
+
+        // Inserts the leaf next to the sibling that increases the total perimeter of the tree the least
+        void insertLeaf(int32_t leaf)
+        {
+            if (root == NULL_NODE)
+            {
+                root = leaf;
+                nodes[root].parent = NULL_NODE;
+                return;
+            }
+
+            const AABB leafBox = nodes[leaf].box;
+            int32_t index = root;
+            while (!nodes[index].isLeaf())
+            {
+                int32_t child1 = nodes[index].child1, child2 = nodes[index].child2;
+                float perimeter = nodes[index].box.getPerimeter();
+                float combinedPerimeter = nodes[index].box.merged(leafBox).getPerimeter();
+
+                // The cost of making a new parent for this node and the leaf
+                float cost = 2.0f * combinedPerimeter;
+                // The minimum cost of pushing the leaf further down the tree
+                float inheritanceCost = 2.0f * (combinedPerimeter - perimeter);
+
+                auto descendCost = [&](int32_t child)
+                {
+                    float newPerimeter = nodes[child].box.merged(leafBox).getPerimeter();
+                    if (nodes[child].isLeaf())
+                        return newPerimeter + inheritanceCost;
+                    return newPerimeter - nodes[child].box.getPerimeter() + inheritanceCost;
+                };
+                float cost1 = descendCost(child1), cost2 = descendCost(child2);
+
+                if (cost < cost1 && cost < cost2)
+                    break;
+                index = cost1 < cost2 ? child1 : child2;
+            }
+
+            int32_t sibling = index;
+            int32_t oldParent = nodes[sibling].parent;
+            int32_t newParent = allocateNode();
+            nodes[newParent].parent = oldParent;
+            nodes[newParent].box = leafBox.merged(nodes[sibling].box);
+            nodes[newParent].height = nodes[sibling].height + 1;
+            nodes[newParent].child1 = sibling;
+            nodes[newParent].child2 = leaf;
+            nodes[sibling].parent = newParent;
+            nodes[leaf].parent = newParent;
+
+            if (oldParent == NULL_NODE)
+                root = newParent;
+            else if (nodes[oldParent].child1 == sibling)
+                nodes[oldParent].child1 = newParent;
+            else
+                nodes[oldParent].child2 = newParent;
+
+            refit(nodes[leaf].parent);
+        }
+
+        void removeLeaf(int32_t leaf)
+        {
+            if (leaf == root)
+            {
+                root = NULL_NODE;
+                return;
+            }
+
+            int32_t parent = nodes[leaf].parent;
+            int32_t grandParent = nodes[parent].parent;
+            int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+            // The sibling takes the place of the parent
+            if (grandParent == NULL_NODE)
+            {
+                root = sibling;
+                nodes[sibling].parent = NULL_NODE;
+            }
+            else
+            {
+                if (nodes[grandParent].child1 == parent)
+                    nodes[grandParent].child1 = sibling;
+                else
+                    nodes[grandParent].child2 = sibling;
+                nodes[sibling].parent = grandParent;
+            }
+            freeNode(parent);
+            refit(grandParent);
+        }
+
+        // Walks up from the given node, balancing the nodes and recomputing their boxes and heights
+        void refit(int32_t index)
+        {
+            while (index != NULL_NODE)
+            {
+                index = balance(index);
+                Node &node = nodes[index];
+                node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+                node.box = nodes[node.child1].box.merged(nodes[node.child2].box);
+                index = node.parent;
+            }
+        }
+
+        // If one child of "a" is more than one level taller than the other, the taller child is rotated up to replace "a"
+        // Returns the index of the node that is now at the position of "a"
+        int32_t balance(int32_t a)
+        {
+            if (nodes[a].isLeaf() || nodes[a].height < 2)
+                return a;
+
+            int32_t b = nodes[a].child1, c = nodes[a].child2;
+            int32_t difference = nodes[c].height - nodes[b].height;
+            if (difference > 1)
+                return rotate(a, c, b);
+            if (difference < -1)
+                return rotate(a, b, c);
+            return a;
+        }
+
+        // Rotates the tall child "up" above its parent "a", "a" keeps the other child "down"
+        // and takes the shorter grandchild from "up"
+        int32_t rotate(int32_t a, int32_t up, int32_t down)
+        {
+            int32_t f = nodes[up].child1, g = nodes[up].child2;
+
+            // "up" takes the place of "a"
+            nodes[up].child1 = a;
+            nodes[up].parent = nodes[a].parent;
+            nodes[a].parent = up;
+            if (nodes[up].parent == NULL_NODE)
+                root = up;
+            else if (nodes[nodes[up].parent].child1 == a)
+                nodes[nodes[up].parent].child1 = up;
+            else
+                nodes[nodes[up].parent].child2 = up;
+
+            // The taller grandchild stays under "up", the shorter one moves under "a"
+            if (nodes[f].height < nodes[g].height)
+                std::swap(f, g);
+            nodes[up].child2 = f;
+            if (nodes[a].child1 == up)
+                nodes[a].child1 = g;
+            else
+                nodes[a].child2 = g;
+            nodes[g].parent = a;
+
+            nodes[a].box = nodes[down].box.merged(nodes[g].box);
+            nodes[a].height = 1 + std::max(nodes[down].height, nodes[g].height);
+            nodes[up].box = nodes[a].box.merged(nodes[f].box);
+            nodes[up].height = 1 + std::max(nodes[a].height, nodes[f].height);
+            return up;
+        }
+
+    public:
+        AABBTree(glm::vec3 margin = glm::vec3(0.1f)) : margin(margin) {}
+
+        // Adds an object with the given (tight) box and returns the ID of its leaf
+        int32_t createProxy(const AABB &box, void *userData)
+        {
+            int32_t proxy = allocateNode();
+            nodes[proxy].box = box.expanded(margin);
+            nodes[proxy].userData = userData;
+            insertLeaf(proxy);
+            return proxy;
+        }
+
+        void destroyProxy(int32_t proxy)
+        {
+            assert(nodes[proxy].isLeaf());
+            removeLeaf(proxy);
+            freeNode(proxy);
+        }
+
+        // Updates the box of an object, the leaf is only reinserted if the box left the fat AABB of the leaf
+        // The new fat AABB is extended in the direction of the displacement to predict where the object is going
+        // Returns true if the leaf was reinserted
+        bool moveProxy(int32_t proxy, const AABB &box, glm::vec3 displacement)
+        {
+            if (nodes[proxy].box.contains(box))
+                return false;
+
+            removeLeaf(proxy);
+            AABB fat = box.expanded(margin);
+            fat.min = glm::min(fat.min, fat.min + displacement);
+            fat.max = glm::max(fat.max, fat.max + displacement);
+            nodes[proxy].box = fat;
+            insertLeaf(proxy);
+            return true;
+        }
+
+        void *getUserData(int32_t proxy) const { return nodes[proxy].userData; }
+        const AABB &getFatAABB(int32_t proxy) const { return nodes[proxy].box; }
+        int32_t getHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+        void clear()
+        {
+            nodes.clear();
+            root = freeList = NULL_NODE;
+        }
+
+        // Calls "callback(proxy)" for every leaf whose fat AABB overlaps the box, the query stops if the callback returns false
+        template <typename Callback>
+        void query(const AABB &box, Callback &&callback) const
+        {
+            if (root == NULL_NODE)
+                return;
+            int32_t stack[STACK_SIZE];
+            int count = 0;
+            stack[count++] = root;
+            while (count > 0)
+            {
+                const Node &node = nodes[stack[--count]];
+                if (!node.box.overlaps(box))
+                    continue;
+                if (node.isLeaf())
+                {
+                    if (!callback(int32_t(&node - nodes.data())))
+                        return;
+                }
+                else
+                {
+                    assert(count + 2 <= STACK_SIZE);
+                    stack[count++] = node.child1;
+                    stack[count++] = node.child2;
+                }
+            }
+        }
+
+        // Calls "callback(proxy, maxDistance)" for every leaf whose fat AABB is hit by the ray "origin + t * direction"
+        // for t in [0, maxDistance] (or by a sphere of the given radius moving along the ray). The callback returns the new maxDistance, so returning the distance of a hit
+        // skips everything behind it (closest hit), returning the same maxDistance keeps all the hits and returning 0 stops the query.
+        template <typename Callback>
+        void raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, Callback &&callback, float radius = 0.0f) const
+        {
+            if (root == NULL_NODE)
+                return;
+            glm::vec3 inverseDirection = 1.0f / direction;
+            int32_t stack[STACK_SIZE];
+            int count = 0;
+            stack[count++] = root;
+            while (count > 0)
+            {
+                const Node &node = nodes[stack[--count]];
+                if (!node.box.expanded(glm::vec3(radius)).intersectsRay(origin, inverseDirection, maxDistance))
+                    continue;
+                if (node.isLeaf())
+                {
+                    maxDistance = callback(int32_t(&node - nodes.data()), maxDistance);
+                    if (maxDistance <= 0.0f)
+                        return;
+                }
+                else
+                {
+                    assert(count + 2 <= STACK_SIZE);
+                    stack[count++] = node.child1;
+                    stack[count++] = node.child2;
+                }
+            }
+        }
+    };
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../../components/rigid-body.hpp"
+#include "../../ecs/entity.hpp"
+#include "sphere.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // An axis aligned bounding box in the world space
+    struct AABB
+    {
+        glm::vec3 min = glm::vec3(0.0f), max = glm::vec3(0.0f);
+
+        bool overlaps(const AABB &other) const
+        {
+            return min.x <= other.max.x && other.min.x <= max.x &&
+                   min.y <= other.max.y && other.min.y <= max.y &&
+                   min.z <= other.max.z && other.min.z <= max.z;
+        }
+
+        bool contains(const AABB &other) const
+        {
+            return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+                   other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+        }
+
+        // Half the surface area, it is the cost used to decide where to insert a box in the AABB tree
+        float getPerimeter() const
+        {
+            glm::vec3 size = max - min;
+            return size.x * size.y + size.y * size.z + size.z * size.x;
+        }
+
+        AABB merged(const AABB &other) const
+        {
+            return {glm::min(min, other.min), glm::max(max, other.max)};
+        }
+
+        AABB expanded(glm::vec3 margin) const
+        {
+            return {min - margin, max + margin};
+        }
+
+        // Slab test of the ray "origin + t * direction" against the box
+        // "inverseDirection" is 1/direction (precomputed once per ray), the test succeeds if the ray enters the box before "maxT"
+        bool intersectsRay(glm::vec3 origin, glm::vec3 inverseDirection, float maxT) const
+        {
+            glm::vec3 t1 = (min - origin) * inverseDirection;
+            glm::vec3 t2 = (max - origin) * inverseDirection;
+            glm::vec3 tMin = glm::min(t1, t2), tMax = glm::max(t1, t2);
+            float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+            float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxT));
+            return enter <= exit;
+        }
+
+        // Returns the AABB that encloses the bounding box (or the sphere) of the rigid body after transforming it to the world space
+        static AABB fromRigidBody(RigidBodyComponent *body)
+        {
+            const glm::mat4 &localToWorld = body->getOwner()->getLocalToWorldMatrix();
+            if (body->bodyType == SPHERE)
+            {
+                Sphere sphere = Sphere::fromRigidBody(body, localToWorld);
+                return {sphere.center - sphere.radius, sphere.center + sphere.radius};
+            }
+            AABB box;
+            box.min = glm::vec3(std::numeric_limits<float>::max());
+            box.max = glm::vec3(-std::numeric_limits<float>::max());
+            for (const glm::vec3 &corner : body->boundingBox)
+            {
+                glm::vec3 point = localToWorld * glm::vec4(corner, 1.0f);
+                box.min = glm::min(box.min, point);
+                box.max = glm::max(box.max, point);
+            }
+            return box;
+        }
+    };
+
+}
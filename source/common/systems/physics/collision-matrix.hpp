@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../../components/rigid-body.hpp"
+
+#include <cstdint>
+
+namespace our
+{
+
+    // Returns the bit of the given tag in a tag mask
+    inline uint32_t tagBit(Tag tag) { return 1u << tag; }
+
+    // The collision matrix tells which pairs of tags interact and how
+    // Solid pairs are pushed apart by the contact solver, trigger pairs only raise events (e.g. the ball entering a goal)
+    // Every tag has a mask of the tags it interacts with, so a pair is rejected with a single AND before any test
+    class CollisionMatrix
+    {
+        uint32_t solidMasks[TAG_COUNT] = {};
+        uint32_t interactionMasks[TAG_COUNT] = {}; // The solid and trigger masks together
+
+    public:
+        // Makes the bodies of the two tags push each other apart
+        void setSolid(Tag a, Tag b)
+        {
+            solidMasks[a] |= tagBit(b);
+            solidMasks[b] |= tagBit(a);
+            setTrigger(a, b);
+        }
+
+        // Makes the contacts between the two tags raise events without pushing the bodies
+        void setTrigger(Tag a, Tag b)
+        {
+            interactionMasks[a] |= tagBit(b);
+            interactionMasks[b] |= tagBit(a);
+        }
+
+        // Removes any interaction between the two tags
+        void ignore(Tag a, Tag b)
+        {
+            solidMasks[a] &= ~tagBit(b);
+            solidMasks[b] &= ~tagBit(a);
+            interactionMasks[a] &= ~tagBit(b);
+            interactionMasks[b] &= ~tagBit(a);
+        }
+
+        // Returns the mask of the tags that interact with the given tag
+        uint32_t getMask(Tag tag) const { return interactionMasks[tag]; }
+
+        bool interacts(Tag a, Tag b) const { return (interactionMasks[a] & tagBit(b)) != 0; }
+        bool isSolid(Tag a, Tag b) const { return (solidMasks[a] & tagBit(b)) != 0; }
+    };
+
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "contact.hpp"
+#include "../../components/rigid-body.hpp"
+#include "../../components/movement.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // A sequential impulse solver for the contacts of a tick
+    // It computes the impulses that stop the bodies from moving into each other (with restitution and friction)
+    // then writes the new velocities back to the movement components.
+    // The bodies and the contacts are stored in structure of arrays form and the solver runs a fixed number of iterations,
+    // so its cost only depends on the number of contacts.
+    // The impulses of the contacts that persist from the last tick are used as the starting guess (warm starting).
+    class ContactSolver
+    {
+        static constexpr int ITERATIONS = 8;
+        static constexpr float BAUMGARTE = 0.2f; // The fraction of the penetration resolved per tick
+        static constexpr float SLOP = 0.01f;     // The penetration allowed without any correction
+        static constexpr float RESTITUTION_THRESHOLD = 0.5f; // Slower impacts do not bounce (so resting contacts stay at rest)
+
+        // The bodies
+        std::vector<RigidBodyComponent *> bodies;
+        std::unordered_map<const RigidBodyComponent *, uint32_t> bodyIndices; // The index of every body of the tick in the arrays
+        std::vector<float> velocityX, velocityY, velocityZ, inverseMass;
+
+        // The contacts
+        std::vector<uint32_t> bodyA, bodyB;
+        std::vector<float> normalX, normalY, normalZ;
+        std::vector<float> tangentX, tangentY, tangentZ;
+        std::vector<float> normalMass, tangentMass, bias, friction;
+        std::vector<float> normalImpulse, tangentImpulse;
+
+        // The accumulated impulses of the last tick
+        struct CachedImpulse
+        {
+            RigidBodyComponent *first, *second;
+            float normal, tangent;
+            bool operator<(const CachedImpulse &other) const
+            {
+                return std::less<>()(first, other.first) || (first == other.first && std::less<>()(second, other.second));
+            }
+        };
+        std::vector<CachedImpulse> cache, nextCache;
+
+        // Returns the direction the movement system moves the body in (its forward vector rotated by the body rotation)
+        static glm::vec3 getDirection(MovementComponent *movement)
+        {
+            glm::vec3 direction = movement->getOwner()->localTransform.convertToLocalSpace(movement->forward);
+            return glm::length(direction) > 0 ? glm::normalize(direction) : glm::vec3(0.0f);
+        }
+
+        // Cars can only move along their forward vector, so they keep the part of the velocity along it
+        // Other bodies (the ball) move in the direction of their new velocity
+        static void setVelocity(RigidBodyComponent *body, MovementComponent *movement, glm::vec3 velocity)
+        {
+            if (body->tag == CAR)
+            {
+                movement->setSpeed(glm::dot(velocity, getDirection(movement)));
+                return;
+            }
+            float speed = glm::length(velocity);
+            movement->setSpeed(speed);
+            if (speed > 0)
+                movement->setForward(velocity);
+        }
+
+        // Returns the index of the body in the arrays (adds it if it is not there yet)
+        uint32_t addBody(RigidBodyComponent *body, MovementComponent *movement)
+        {
+            auto [found, added] = bodyIndices.try_emplace(body, (uint32_t)bodies.size());
+            if (!added)
+                return found->second;
+
+            // static bodies and bodies moved towards a target (not by a velocity) have an infinite mass
+            bool dynamic = movement != nullptr && !body->isStaticBody() && !movement->directedMovementMode && body->mass > 0;
+            glm::vec3 velocity = dynamic ? getDirection(movement) * movement->current_velocity : glm::vec3(0.0f);
+            bodies.push_back(body);
+            velocityX.push_back(velocity.x);
+            velocityY.push_back(velocity.y);
+            velocityZ.push_back(velocity.z);
+            inverseMass.push_back(dynamic ? 1.0f / body->mass : 0.0f);
+            return (uint32_t)bodies.size() - 1;
+        }
+
+        void applyImpulse(uint32_t contact, float impulseX, float impulseY, float impulseZ)
+        {
+            uint32_t a = bodyA[contact], b = bodyB[contact];
+            velocityX[a] -= impulseX * inverseMass[a];
+            velocityY[a] -= impulseY * inverseMass[a];
+            velocityZ[a] -= impulseZ * inverseMass[a];
+            velocityX[b] += impulseX * inverseMass[b];
+            velocityY[b] += impulseY * inverseMass[b];
+            velocityZ[b] += impulseZ * inverseMass[b];
+        }
+
+        void clear()
+        {
+            for (auto *array : {&velocityX, &velocityY, &velocityZ, &inverseMass, &normalX, &normalY, &normalZ, &tangentX, &tangentY, &tangentZ,
+                                &normalMass, &tangentMass, &bias, &friction, &normalImpulse, &tangentImpulse})
+                array->clear();
+            bodies.clear();
+            bodyIndices.clear();
+            bodyA.clear();
+            bodyB.clear();
+        }
+
+    public:
+        // Solves the given contacts and updates the velocities of the bodies in their movement components
+        void solve(const std::vector<const Contact *> &contacts, float deltaTime)
+        {
+            clear();
+            nextCache.clear();
+
+            // Prepare the contacts
+            for (const Contact *contact : contacts)
+            {
+                MovementComponent *movementA = contact->first->getOwner()->getComponent<MovementComponent>();
+                MovementComponent *movementB = contact->second->getOwner()->getComponent<MovementComponent>();
+                uint32_t a = addBody(contact->first, movementA), b = addBody(contact->second, movementB);
+                float massSum = inverseMass[a] + inverseMass[b];
+                if (massSum == 0)
+                    continue;
+
+                glm::vec3 normal = contact->normal;
+                glm::vec3 relativeVelocity = glm::vec3(velocityX[b] - velocityX[a], velocityY[b] - velocityY[a], velocityZ[b] - velocityZ[a]);
+                float normalVelocity = glm::dot(relativeVelocity, normal);
+                glm::vec3 tangent = relativeVelocity - normalVelocity * normal;
+                tangent = glm::length(tangent) > 1e-6f ? glm::normalize(tangent) : glm::vec3(0.0f);
+
+                float restitution = std::max(contact->first->restitution, contact->second->restitution);
+                float bounce = normalVelocity < -RESTITUTION_THRESHOLD ? -restitution * normalVelocity : 0.0f;
+                float correction = BAUMGARTE / deltaTime * std::max(contact->penetration - SLOP, 0.0f);
+
+                bodyA.push_back(a);
+                bodyB.push_back(b);
+                normalX.push_back(normal.x);
+                normalY.push_back(normal.y);
+                normalZ.push_back(normal.z);
+                tangentX.push_back(tangent.x);
+                tangentY.push_back(tangent.y);
+                tangentZ.push_back(tangent.z);
+                normalMass.push_back(1.0f / massSum);
+                tangentMass.push_back(1.0f / massSum);
+                bias.push_back(std::max(bounce, correction));
+                friction.push_back(std::sqrt(contact->first->friction * contact->second->friction));
+
+                // Warm start from the impulses of the same pair in the last tick
+                CachedImpulse key{contact->first, contact->second, 0.0f, 0.0f};
+                auto found = std::lower_bound(cache.begin(), cache.end(), key);
+                bool persistent = found != cache.end() && found->first == key.first && found->second == key.second;
+                normalImpulse.push_back(persistent ? found->normal : 0.0f);
+                tangentImpulse.push_back(persistent ? found->tangent : 0.0f);
+            }
+
+            size_t count = bodyA.size();
+            for (size_t c = 0; c < count; c++)
+            {
+                applyImpulse(c, normalX[c] * normalImpulse[c] + tangentX[c] * tangentImpulse[c],
+                             normalY[c] * normalImpulse[c] + tangentY[c] * tangentImpulse[c],
+                             normalZ[c] * normalImpulse[c] + tangentZ[c] * tangentImpulse[c]);
+            }
+
+            // Solve the contacts one after the other for a fixed number of iterations
+            for (int iteration = 0; iteration < ITERATIONS; iteration++)
+            {
+                for (size_t c = 0; c < count; c++)
+                {
+                    uint32_t a = bodyA[c], b = bodyB[c];
+                    float relativeX = velocityX[b] - velocityX[a], relativeY = velocityY[b] - velocityY[a], relativeZ = velocityZ[b] - velocityZ[a];
+
+                    // The normal impulse stops the bodies from approaching (the accumulated impulse can only push)
+                    float normalVelocity = relativeX * normalX[c] + relativeY * normalY[c] + relativeZ * normalZ[c];
+                    float impulse = normalMass[c] * (bias[c] - normalVelocity);
+                    float accumulated = std::max(normalImpulse[c] + impulse, 0.0f);
+                    impulse = accumulated - normalImpulse[c];
+                    normalImpulse[c] = accumulated;
+                    applyImpulse(c, normalX[c] * impulse, normalY[c] * impulse, normalZ[c] * impulse);
+
+                    // The friction impulse opposes the sliding and is limited by the normal impulse
+                    relativeX = velocityX[b] - velocityX[a], relativeY = velocityY[b] - velocityY[a], relativeZ = velocityZ[b] - velocityZ[a];
+                    float tangentVelocity = relativeX * tangentX[c] + relativeY * tangentY[c] + relativeZ * tangentZ[c];
+                    float maxFriction = friction[c] * normalImpulse[c];
+                    float tangentImpulseDelta = -tangentMass[c] * tangentVelocity;
+                    float accumulatedTangent = glm::clamp(tangentImpulse[c] + tangentImpulseDelta, -maxFriction, maxFriction);
+                    tangentImpulseDelta = accumulatedTangent - tangentImpulse[c];
+                    tangentImpulse[c] = accumulatedTangent;
+                    applyImpulse(c, tangentX[c] * tangentImpulseDelta, tangentY[c] * tangentImpulseDelta, tangentZ[c] * tangentImpulseDelta);
+                }
+            }
+
+            // Keep the impulses for the next tick
+            for (size_t c = 0; c < count; c++)
+                nextCache.push_back({bodies[bodyA[c]], bodies[bodyB[c]], normalImpulse[c], tangentImpulse[c]});
+            std::sort(nextCache.begin(), nextCache.end());
+            std::swap(cache, nextCache);
+
+            // Write the new velocities of the dynamic bodies back
+            for (size_t index = 0; index < bodies.size(); index++)
+            {
+                if (inverseMass[index] == 0)
+                    continue;
+                MovementComponent *movement = bodies[index]->getOwner()->getComponent<MovementComponent>();
+                setVelocity(bodies[index], movement, glm::vec3(velocityX[index], velocityY[index], velocityZ[index]));
+            }
+        }
+
+        // Forgets the impulses of the last tick (e.g. after the world was reset)
+        void reset()
+        {
+            cache.clear();
+        }
+    };
+
+}
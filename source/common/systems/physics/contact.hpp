@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../../components/rigid-body.hpp"
+
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // A contact between two rigid bodies found by the narrowphase
+    // All the collision responses of a tick read the same list of contacts instead of testing the pairs again
+    struct Contact
+    {
+        RigidBodyComponent *first, *second;
+        Tag firstTag, secondTag;
+        glm::vec3 normal;  // The separating axis with the least overlap, it points from the first body to the second
+        float penetration; // How much the bodies overlap along the normal
+
+        // Returns the body of the contact that has the given tag (the first one if both have it)
+        RigidBodyComponent *get(Tag tag) const
+        {
+            return firstTag == tag ? first : second;
+        }
+
+        // Returns the normal pointing from the given body to the other one
+        glm::vec3 getNormalFrom(RigidBodyComponent *body) const
+        {
+            return body == first ? normal : -normal;
+        }
+    };
+
+}
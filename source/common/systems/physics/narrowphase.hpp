@@ -0,0 +1,195 @@
+#pragma once
+
+#include "obb.hpp"
+#include "sphere.hpp"
+#include "sat.hpp"
+#include "triangle-mesh.hpp"
+#include "../../components/rigid-body.hpp"
+
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // The shape of a rigid body in the world space for the current tick
+    // Only the member that matches the body type is filled (a mesh also fills the box with its bounds)
+    struct Collider
+    {
+        BodyType type = CUBE;
+        OBB box;
+        Sphere sphere;
+
+        // The mesh stays in its local space, the other shapes are moved to that space to be tested against it
+        // NOTE: the scale of a mesh body should be uniform
+        const TriangleMesh *mesh = nullptr;
+        glm::mat4 meshToWorld = glm::mat4(1.0f), worldToMesh = glm::mat4(1.0f);
+        float meshScale = 1.0f;
+
+        static Collider fromRigidBody(const RigidBodyComponent *body)
+        {
+            Collider collider;
+            collider.type = body->bodyType;
+            const glm::mat4 &localToWorld = body->getOwner()->getLocalToWorldMatrix();
+            if (collider.type == SPHERE)
+                collider.sphere = Sphere::fromRigidBody(body, localToWorld);
+            else
+                collider.box = OBB::fromRigidBody(body, localToWorld);
+            if (collider.type == MESH)
+            {
+                collider.mesh = body->mesh;
+                collider.meshToWorld = localToWorld;
+                collider.worldToMesh = glm::inverse(localToWorld);
+                collider.meshScale = glm::length(glm::vec3(localToWorld[0]));
+            }
+            return collider;
+        }
+
+        // Moves a contact found in the space of the mesh back to the world space
+        CollisionResult meshResultToWorld(CollisionResult result) const
+        {
+            if (!result.collided)
+                return result;
+            result.normal = glm::normalize(glm::vec3(meshToWorld * glm::vec4(result.normal, 0.0f)));
+            result.penetration *= meshScale;
+            return result;
+        }
+    };
+
+    // Tests two spheres, the normal points from the center of a to the center of b
+    inline CollisionResult testSpheres(const Sphere &a, const Sphere &b)
+    {
+        CollisionResult result;
+        glm::vec3 offset = b.center - a.center;
+        float distanceSquared = glm::dot(offset, offset);
+        float radii = a.radius + b.radius;
+        if (distanceSquared > radii * radii)
+            return result;
+
+        float distance = glm::sqrt(distanceSquared);
+        result.collided = true;
+        result.normal = distance > 1e-6f ? offset / distance : glm::vec3(0.0f, 1.0f, 0.0f);
+        result.penetration = radii - distance;
+        return result;
+    }
+
+    // Tests a sphere against a box using the point of the box closest to the sphere center
+    // The normal points from the sphere to the box
+    inline CollisionResult testSphereOBB(const Sphere &sphere, const OBB &box)
+    {
+        CollisionResult result;
+        glm::vec3 offset = sphere.center - box.center;
+        glm::vec3 local; // The sphere center in the frame of the box
+        glm::vec3 closest = box.center;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            local[axis] = glm::dot(offset, box.axes[axis]);
+            closest += box.axes[axis] * glm::clamp(local[axis], -box.halfExtents[axis], box.halfExtents[axis]);
+        }
+
+        glm::vec3 separation = sphere.center - closest;
+        float distanceSquared = glm::dot(separation, separation);
+        if (distanceSquared > sphere.radius * sphere.radius)
+            return result;
+
+        result.collided = true;
+        if (distanceSquared > 1e-12f)
+        {
+            float distance = glm::sqrt(distanceSquared);
+            result.normal = -separation / distance;
+            result.penetration = sphere.radius - distance;
+            return result;
+        }
+
+        // The center is inside the box, so the sphere is pushed out through the nearest face
+        int nearestAxis = 0;
+        float nearestDepth = box.halfExtents[0] - glm::abs(local[0]);
+        for (int axis = 1; axis < 3; axis++)
+        {
+            float depth = box.halfExtents[axis] - glm::abs(local[axis]);
+            if (depth < nearestDepth)
+            {
+                nearestDepth = depth;
+                nearestAxis = axis;
+            }
+        }
+        glm::vec3 outward = box.axes[nearestAxis] * (local[nearestAxis] < 0.0f ? -1.0f : 1.0f);
+        result.normal = -outward;
+        result.penetration = sphere.radius + nearestDepth;
+        return result;
+    }
+
+    // The collision test of every pair of body types, the specializations are selected at compile time
+    template <BodyType A, BodyType B>
+    CollisionResult collide(const Collider &a, const Collider &b);
+
+    template <>
+    inline CollisionResult collide<CUBE, CUBE>(const Collider &a, const Collider &b) { return testOBBs(a.box, b.box); }
+
+    template <>
+    inline CollisionResult collide<SPHERE, CUBE>(const Collider &a, const Collider &b) { return testSphereOBB(a.sphere, b.box); }
+
+    template <>
+    inline CollisionResult collide<CUBE, SPHERE>(const Collider &a, const Collider &b)
+    {
+        CollisionResult result = testSphereOBB(b.sphere, a.box);
+        result.normal = -result.normal; // The normal should point from a to b
+        return result;
+    }
+
+    template <>
+    inline CollisionResult collide<SPHERE, SPHERE>(const Collider &a, const Collider &b) { return testSpheres(a.sphere, b.sphere); }
+
+    template <>
+    inline CollisionResult collide<SPHERE, MESH>(const Collider &a, const Collider &b)
+    {
+        glm::vec3 center = b.worldToMesh * glm::vec4(a.sphere.center, 1.0f);
+        return b.meshResultToWorld(b.mesh->testSphere(center, a.sphere.radius / b.meshScale));
+    }
+
+    template <>
+    inline CollisionResult collide<CUBE, MESH>(const Collider &a, const Collider &b)
+    {
+        OBB box;
+        box.center = b.worldToMesh * glm::vec4(a.box.center, 1.0f);
+        for (int axis = 0; axis < 3; axis++)
+            box.axes[axis] = glm::normalize(glm::vec3(b.worldToMesh * glm::vec4(a.box.axes[axis], 0.0f)));
+        box.halfExtents = a.box.halfExtents / b.meshScale;
+        return b.meshResultToWorld(b.mesh->testOBB(box));
+    }
+
+    template <>
+    inline CollisionResult collide<MESH, SPHERE>(const Collider &a, const Collider &b)
+    {
+        CollisionResult result = collide<SPHERE, MESH>(b, a);
+        result.normal = -result.normal; // The normal should point from a to b
+        return result;
+    }
+
+    template <>
+    inline CollisionResult collide<MESH, CUBE>(const Collider &a, const Collider &b)
+    {
+        CollisionResult result = collide<CUBE, MESH>(b, a);
+        result.normal = -result.normal;
+        return result;
+    }
+
+    // Meshes are static, so they are never tested against each other
+    template <>
+    inline CollisionResult collide<MESH, MESH>(const Collider &, const Collider &) { return {}; }
+
+    typedef CollisionResult (*CollideFunction)(const Collider &, const Collider &);
+
+    // The table of collision tests indexed by the body types of the two colliders
+    constexpr CollideFunction COLLIDE_TABLE[BODY_TYPE_COUNT][BODY_TYPE_COUNT] = {
+        {&collide<CUBE, CUBE>, &collide<CUBE, SPHERE>, &collide<CUBE, MESH>},
+        {&collide<SPHERE, CUBE>, &collide<SPHERE, SPHERE>, &collide<SPHERE, MESH>},
+        {&collide<MESH, CUBE>, &collide<MESH, SPHERE>, &collide<MESH, MESH>},
+    };
+
+    // Tests two colliders of any type, the normal of the result points from a to b
+    inline CollisionResult collide(const Collider &a, const Collider &b)
+    {
+        return COLLIDE_TABLE[a.type][b.type](a, b);
+    }
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../../components/rigid-body.hpp"
+#include "../../ecs/entity.hpp"
+
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // An oriented bounding box in the world space
+    // It is built once per body per tick, so the collision tests never transform the corners of the body again
+    struct OBB
+    {
+        glm::vec3 center = glm::vec3(0.0f);
+        glm::vec3 axes[3] = {glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, 1)}; // The local axes of the box in the world space (normalized)
+        glm::vec3 halfExtents = glm::vec3(0.0f);                                          // The half size of the box along each of its axes
+
+        // Returns the OBB of the bounding box of the rigid body after transforming it by the given local to world matrix
+        // The scale of the matrix is moved from the axes to the half extents
+        static OBB fromRigidBody(const RigidBodyComponent *body, const glm::mat4 &localToWorld)
+        {
+            OBB box;
+            glm::vec3 localCenter = (body->min_point + body->max_point) * 0.5f;
+            glm::vec3 localHalfExtents = (body->max_point - body->min_point) * 0.5f;
+            box.center = localToWorld * glm::vec4(localCenter, 1.0f);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                glm::vec3 column = localToWorld[axis];
+                float length = glm::length(column);
+                if (length > 0.0f)
+                    box.axes[axis] = column / length;
+                box.halfExtents[axis] = localHalfExtents[axis] * length;
+            }
+            return box;
+        }
+
+        static OBB fromRigidBody(const RigidBodyComponent *body)
+        {
+            return fromRigidBody(body, body->getOwner()->getLocalToWorldMatrix());
+        }
+    };
+
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+#include "aabb.hpp"
+#include "aabb-tree.hpp"
+#include "collision-matrix.hpp"
+#include "triangle-mesh.hpp"
+#include "../../components/rigid-body.hpp"
+#include "../../ecs/world.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // Selects the bodies a query can hit
+    struct QueryFilter
+    {
+        Entity *ignore = nullptr; // This entity is never hit (e.g. the entity that casts the ray)
+        uint32_t tagMask = ~0u;   // Only the bodies whose tag bit is in the mask are hit
+
+        bool accepts(RigidBodyComponent *body) const
+        {
+            return body->getOwner() != ignore && (tagMask & tagBit(body->tag)) != 0;
+        }
+    };
+
+    // The result of a query against a single body
+    struct QueryHit
+    {
+        Entity *entity = nullptr;
+        RigidBodyComponent *body = nullptr;
+        float distance = 0.0f; // Casts: how far the ray (or the sphere center) travelled. Overlaps: the distance from the query center to the body (0 if inside)
+        glm::vec3 point = glm::vec3(0.0f);  // The point of the body that was hit (the closest point for overlaps)
+        glm::vec3 normal = glm::vec3(0.0f); // The surface normal of the body at the hit point (pointing away from the body)
+    };
+
+    // This class answers spatial queries (raycast, sphere cast, box and sphere overlap) about the rigid bodies of a world.
+    // The bodies are kept in a dynamic AABB tree, so a query only tests the few bodies near it (logarithmic cost).
+    // The tree is rebuilt when the bodies of the world change and refitted every tick by "update".
+    // The bodies are tested as oriented boxes: the bounding box of the body in its local space transformed by its local to world matrix.
+    class PhysicsQueries
+    {
+        AABBTree tree;
+        std::vector<RigidBodyComponent *> bodies; // The bodies in the tree (in the order of the world component list)
+        std::vector<int32_t> proxies;             // The leaf of each body
+        std::vector<AABB> boxes;                  // The AABB of each body at the last update (to skip the bodies that did not move and predict the motion of the others)
+        size_t entitiesVersion = 0;               // The version of the world entities when the tree was built
+
+        // Intersects the ray with the bounding box (or the triangles of the mesh) of the body in its local space, the box is grown by "radius" (in world units)
+        // The parameter t does not change between the spaces since the direction is transformed without being normalized
+        static bool castAgainstBody(RigidBodyComponent *body, glm::vec3 origin, glm::vec3 direction, float radius, float maxDistance, QueryHit &hit)
+        {
+            Entity *owner = body->getOwner();
+            const glm::mat4 &localToWorld = owner->getLocalToWorldMatrix();
+            glm::mat4 worldToLocal = glm::transpose(owner->getLocalToWorldInverseTranspose());
+
+            glm::vec3 localOrigin = worldToLocal * glm::vec4(origin, 1.0f);
+            glm::vec3 localDirection = worldToLocal * glm::vec4(direction, 0.0f);
+
+            // A ray is tested against the triangles of a mesh (a sphere is still tested against its bounding box)
+            if (body->bodyType == MESH && radius == 0.0f)
+            {
+                float t;
+                glm::vec3 localNormal;
+                if (!body->mesh->raycast(localOrigin, localDirection, maxDistance, t, localNormal))
+                    return false;
+                hit.entity = owner;
+                hit.body = body;
+                hit.distance = t;
+                hit.point = origin + direction * t;
+                hit.normal = glm::normalize(glm::vec3(owner->getLocalToWorldInverseTranspose() * glm::vec4(localNormal, 0.0f)));
+                return true;
+            }
+
+            // The radius in the units of every local axis
+            glm::vec3 axisScale(glm::length(glm::vec3(localToWorld[0])), glm::length(glm::vec3(localToWorld[1])), glm::length(glm::vec3(localToWorld[2])));
+            glm::vec3 localRadius = radius / glm::max(axisScale, glm::vec3(1e-6f));
+            glm::vec3 boxMin = body->min_point - localRadius, boxMax = body->max_point + localRadius;
+
+            float enter = 0.0f, exit = maxDistance;
+            int enterAxis = -1;
+            float enterSign = 0.0f;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (glm::abs(localDirection[axis]) < 1e-8f)
+                {
+                    if (localOrigin[axis] < boxMin[axis] || localOrigin[axis] > boxMax[axis])
+                        return false;
+                    continue;
+                }
+                float inverse = 1.0f / localDirection[axis];
+                float t1 = (boxMin[axis] - localOrigin[axis]) * inverse;
+                float t2 = (boxMax[axis] - localOrigin[axis]) * inverse;
+                float sign = -1.0f; // The ray enters through the min face
+                if (t1 > t2)
+                {
+                    std::swap(t1, t2);
+                    sign = 1.0f;
+                }
+                if (t1 > enter)
+                {
+                    enter = t1;
+                    enterAxis = axis;
+                    enterSign = sign;
+                }
+                exit = std::min(exit, t2);
+                if (enter > exit)
+                    return false;
+            }
+            // A ray that starts inside the body does not hit it
+            if (enterAxis < 0)
+                return false;
+
+            glm::vec3 localNormal(0.0f);
+            localNormal[enterAxis] = enterSign;
+            hit.entity = owner;
+            hit.body = body;
+            hit.distance = enter;
+            hit.point = origin + direction * enter;
+            hit.normal = glm::normalize(glm::vec3(owner->getLocalToWorldInverseTranspose() * glm::vec4(localNormal, 0.0f)));
+            if (radius > 0.0f)
+                hit.point -= hit.normal * radius; // The contact point is on the surface of the sphere
+            return true;
+        }
+
+        // Finds the point of the oriented box of the body that is closest to the given point
+        static glm::vec3 closestPointOnBody(RigidBodyComponent *body, glm::vec3 point)
+        {
+            const glm::mat4 &localToWorld = body->getOwner()->getLocalToWorldMatrix();
+            glm::vec3 localCenter = (body->min_point + body->max_point) * 0.5f;
+            glm::vec3 halfExtents = (body->max_point - body->min_point) * 0.5f;
+            glm::vec3 center = localToWorld * glm::vec4(localCenter, 1.0f);
+
+            glm::vec3 closest = center;
+            glm::vec3 offset = point - center;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                glm::vec3 column = localToWorld[axis];
+                float length = glm::length(column);
+                if (length < 1e-6f)
+                    continue;
+                glm::vec3 direction = column / length;
+                float extent = halfExtents[axis] * length;
+                closest += direction * glm::clamp(glm::dot(offset, direction), -extent, extent);
+            }
+            return closest;
+        }
+
+        void rebuild(const std::vector<RigidBodyComponent *> &worldBodies, size_t version)
+        {
+            tree.clear();
+            entitiesVersion = version;
+            bodies = worldBodies;
+            proxies.clear();
+            boxes.clear();
+            for (RigidBodyComponent *body : bodies)
+            {
+                AABB box = AABB::fromRigidBody(body);
+                proxies.push_back(tree.createProxy(box, body));
+                boxes.push_back(box);
+            }
+        }
+
+    public:
+        // Keeps the tree in sync with the rigid bodies of the world, it should run once per tick after the bodies moved
+        // The tree is rebuilt when entities are added or deleted (the memory of deleted bodies is reused by new ones)
+        // It only reads the rigid bodies and the world transforms, so it can run while the collision system updates the movements
+        void update(World *world)
+        {
+            const std::vector<RigidBodyComponent *> &worldBodies = world->getComponents<RigidBodyComponent>();
+            if (world->getEntitiesVersion() != entitiesVersion || worldBodies != bodies)
+            {
+                rebuild(worldBodies, world->getEntitiesVersion());
+                return;
+            }
+            for (size_t index = 0; index < bodies.size(); index++)
+            {
+                if (bodies[index]->isStaticBody())
+                    continue;
+                // the bodies that did not move (e.g. sleeping bodies) are not refitted
+                AABB box = AABB::fromRigidBody(bodies[index]);
+                if (box.min == boxes[index].min && box.max == boxes[index].max)
+                    continue;
+                glm::vec3 displacement = (box.min + box.max - boxes[index].min - boxes[index].max) * 0.5f;
+                tree.moveProxy(proxies[index], box, displacement);
+                boxes[index] = box;
+            }
+        }
+
+        // Finds the closest body hit by the ray that starts at "origin" and goes along "direction" for at most "maxDistance"
+        // Returns true if a body was hit and stores it in "hit"
+        bool raycast(glm::vec3 origin, glm::vec3 direction, float maxDistance, QueryHit &hit, const QueryFilter &filter = {}) const
+        {
+            return sphereCast(origin, 0.0f, direction, maxDistance, hit, filter);
+        }
+
+        // Finds the first body touched by a sphere of the given radius that moves from "origin" along "direction" for at most "maxDistance"
+        // NOTE: The sphere is swept as a box of the same radius against the body, so it can report a hit slightly early near the corners
+        bool sphereCast(glm::vec3 origin, float radius, glm::vec3 direction, float maxDistance, QueryHit &hit, const QueryFilter &filter = {}) const
+        {
+            if (glm::length(direction) < 1e-8f)
+                return false;
+            direction = glm::normalize(direction);
+            bool found = false;
+            tree.raycast(origin, direction, maxDistance, [&](int32_t proxy, float currentMax)
+            {
+                auto *body = static_cast<RigidBodyComponent *>(tree.getUserData(proxy));
+                QueryHit candidate;
+                if (!filter.accepts(body) || !castAgainstBody(body, origin, direction, radius, currentMax, candidate))
+                    return currentMax;
+                hit = candidate;
+                found = true;
+                return candidate.distance; // Everything behind this hit can be skipped
+            }, radius);
+            return found;
+        }
+
+        // Finds all the bodies whose world space AABB overlaps the given box and adds them to "hits"
+        // Returns the number of bodies found
+        size_t overlapBox(glm::vec3 center, glm::vec3 halfExtents, std::vector<QueryHit> &hits, const QueryFilter &filter = {}) const
+        {
+            size_t count = 0;
+            AABB box{center - halfExtents, center + halfExtents};
+            tree.query(box, [&](int32_t proxy)
+            {
+                auto *body = static_cast<RigidBodyComponent *>(tree.getUserData(proxy));
+                if (!filter.accepts(body) || !AABB::fromRigidBody(body).overlaps(box))
+                    return true;
+                QueryHit overlap;
+                overlap.entity = body->getOwner();
+                overlap.body = body;
+                overlap.point = closestPointOnBody(body, center);
+                overlap.distance = glm::length(center - overlap.point);
+                if (overlap.distance > 0.0f)
+                    overlap.normal = (center - overlap.point) / overlap.distance;
+                hits.push_back(overlap);
+                count++;
+                return true;
+            });
+            return count;
+        }
+
+        // Finds all the bodies that overlap the given sphere and adds them to "hits"
+        // Returns the number of bodies found
+        size_t overlapSphere(glm::vec3 center, float radius, std::vector<QueryHit> &hits, const QueryFilter &filter = {}) const
+        {
+            size_t count = 0;
+            AABB box{center - glm::vec3(radius), center + glm::vec3(radius)};
+            tree.query(box, [&](int32_t proxy)
+            {
+                auto *body = static_cast<RigidBodyComponent *>(tree.getUserData(proxy));
+                if (!filter.accepts(body))
+                    return true;
+                glm::vec3 closest = closestPointOnBody(body, center);
+                float distance = glm::length(center - closest);
+                if (distance > radius)
+                    return true;
+                QueryHit overlap;
+                overlap.entity = body->getOwner();
+                overlap.body = body;
+                overlap.point = closest;
+                overlap.distance = distance;
+                if (distance > 0.0f)
+                    overlap.normal = (center - closest) / distance;
+                hits.push_back(overlap);
+                count++;
+                return true;
+            });
+            return count;
+        }
+
+        // Returns the height of the tree (useful to check that it stays balanced)
+        int getTreeHeight() const { return tree.getHeight(); }
+    };
+
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "obb.hpp"
+#include "../simd.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // The result of a collision test between two shapes
+    struct CollisionResult
+    {
+        bool collided = false;
+        glm::vec3 normal = glm::vec3(0.0f); // The direction of least penetration, it points from the first shape to the second
+        float penetration = 0.0f;           // The overlap of the shapes along the normal
+    };
+
+    namespace sat
+    {
+        using namespace simd;
+
+        // The data of one OBB per lane
+        template <typename Real>
+        struct OBBLanes
+        {
+            Real center[3];
+            Real axes[3][3]; // axes[axis][component]
+            Real halfExtents[3];
+        };
+
+        // The separating axis test of Gottschalk et al. on the 15 candidate axes (3 + 3 face normals and 9 edge cross products)
+        // The radius of each box on an axis is computed analytically from its half extents (no corner is projected)
+        // It returns the minimum overlap over all the axes (negative if an axis separates the boxes) and the index of that axis:
+        // 0-2 are the axes of A, 3-5 are the axes of B and 6 + 3 * i + j is the cross product of the axis i of A and the axis j of B
+        template <typename Real>
+        inline void kernel(const OBBLanes<Real> &A, const OBBLanes<Real> &B, Real &penetration, Real &axisIndex)
+        {
+            const Real epsilon = 1e-6f; // Added to the absolute rotation to handle (almost) parallel edges
+
+            Real d[3], t[3], R[3][3], AbsR[3][3];
+            for (int c = 0; c < 3; c++)
+                d[c] = B.center[c] - A.center[c];
+            // The translation and the rotation of B in the frame of A
+            for (int i = 0; i < 3; i++)
+            {
+                t[i] = d[0] * A.axes[i][0] + d[1] * A.axes[i][1] + d[2] * A.axes[i][2];
+                for (int j = 0; j < 3; j++)
+                {
+                    R[i][j] = A.axes[i][0] * B.axes[j][0] + A.axes[i][1] * B.axes[j][1] + A.axes[i][2] * B.axes[j][2];
+                    AbsR[i][j] = absolute(R[i][j]) + epsilon;
+                }
+            }
+
+            Real best = FLT_MAX, bestAxis = -1.0f;
+            auto consider = [&](Real overlap, float index)
+            {
+                auto mask = lessThan(overlap, best);
+                best = select(mask, overlap, best);
+                bestAxis = select(mask, Real(index), bestAxis);
+            };
+
+            // The axes of A
+            for (int i = 0; i < 3; i++)
+            {
+                Real rb = B.halfExtents[0] * AbsR[i][0] + B.halfExtents[1] * AbsR[i][1] + B.halfExtents[2] * AbsR[i][2];
+                consider(A.halfExtents[i] + rb - absolute(t[i]), float(i));
+            }
+            // The axes of B
+            for (int j = 0; j < 3; j++)
+            {
+                Real ra = A.halfExtents[0] * AbsR[0][j] + A.halfExtents[1] * AbsR[1][j] + A.halfExtents[2] * AbsR[2][j];
+                Real distance = absolute(t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j]);
+                consider(ra + B.halfExtents[j] - distance, float(3 + j));
+            }
+            // The cross products, the overlap is divided by the length of the axis to get a distance
+            // Almost parallel edges give a degenerate axis that is already covered by the face axes, so it is skipped
+            for (int i = 0; i < 3; i++)
+            {
+                int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+                for (int j = 0; j < 3; j++)
+                {
+                    int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+                    Real ra = A.halfExtents[i1] * AbsR[i2][j] + A.halfExtents[i2] * AbsR[i1][j];
+                    Real rb = B.halfExtents[j1] * AbsR[i][j2] + B.halfExtents[j2] * AbsR[i][j1];
+                    Real distance = absolute(t[i2] * R[i1][j] - t[i1] * R[i2][j]);
+                    Real lengthSquared = maximum(Real(1.0f) - R[i][j] * R[i][j], 0.0f);
+                    auto degenerate = lessThan(lengthSquared, 1e-6f);
+                    Real length = squareRoot(maximum(lengthSquared, 1e-6f));
+                    consider(select(degenerate, Real(FLT_MAX), (ra + rb - distance) / length), float(6 + 3 * i + j));
+                }
+            }
+
+            penetration = best;
+            axisIndex = bestAxis;
+        }
+
+        inline void load(OBBLanes<float> &lanes, const OBB &box)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                lanes.center[c] = box.center[c];
+                lanes.halfExtents[c] = box.halfExtents[c];
+                for (int axis = 0; axis < 3; axis++)
+                    lanes.axes[axis][c] = box.axes[axis][c];
+            }
+        }
+
+#ifdef OUR_USE_SSE
+        // Transposes 4 boxes into the lanes (box k goes to lane k)
+        inline void load(OBBLanes<Float4> &lanes, const OBB *b0, const OBB *b1, const OBB *b2, const OBB *b3)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                lanes.center[c] = _mm_setr_ps(b0->center[c], b1->center[c], b2->center[c], b3->center[c]);
+                lanes.halfExtents[c] = _mm_setr_ps(b0->halfExtents[c], b1->halfExtents[c], b2->halfExtents[c], b3->halfExtents[c]);
+                for (int axis = 0; axis < 3; axis++)
+                    lanes.axes[axis][c] = _mm_setr_ps(b0->axes[axis][c], b1->axes[axis][c], b2->axes[axis][c], b3->axes[axis][c]);
+            }
+        }
+#endif
+
+        // Builds the result of a pair from the output of the kernel
+        inline CollisionResult makeResult(const OBB &a, const OBB &b, float penetration, int axisIndex)
+        {
+            CollisionResult result;
+            result.collided = penetration >= 0.0f;
+            if (!result.collided)
+                return result;
+
+            glm::vec3 normal;
+            if (axisIndex < 3)
+                normal = a.axes[axisIndex];
+            else if (axisIndex < 6)
+                normal = b.axes[axisIndex - 3];
+            else
+                normal = glm::normalize(glm::cross(a.axes[(axisIndex - 6) / 3], b.axes[(axisIndex - 6) % 3]));
+            if (glm::dot(normal, b.center - a.center) < 0.0f)
+                normal = -normal;
+
+            result.normal = normal;
+            result.penetration = penetration;
+            return result;
+        }
+    }
+
+    // Tests a single pair of boxes
+    inline CollisionResult testOBBs(const OBB &a, const OBB &b)
+    {
+        sat::OBBLanes<float> A, B;
+        sat::load(A, a);
+        sat::load(B, b);
+        float penetration, axisIndex;
+        sat::kernel(A, B, penetration, axisIndex);
+        return sat::makeResult(a, b, penetration, (int)axisIndex);
+    }
+
+    // Tests many pairs of boxes at once, "pairs" holds the indices of the two boxes of each pair in "boxes"
+    // With SSE, 4 pairs are tested together (one per lane), the remaining pairs are tested one by one
+    inline void testOBBPairs(const OBB *boxes, const std::pair<uint32_t, uint32_t> *pairs, size_t count, CollisionResult *results)
+    {
+        size_t index = 0;
+#ifdef OUR_USE_SSE
+        for (; index + 4 <= count; index += 4)
+        {
+            const std::pair<uint32_t, uint32_t> *p = pairs + index;
+            sat::OBBLanes<sat::Float4> A, B;
+            sat::load(A, &boxes[p[0].first], &boxes[p[1].first], &boxes[p[2].first], &boxes[p[3].first]);
+            sat::load(B, &boxes[p[0].second], &boxes[p[1].second], &boxes[p[2].second], &boxes[p[3].second]);
+            sat::Float4 penetration, axisIndex;
+            sat::kernel(A, B, penetration, axisIndex);
+
+            alignas(16) float penetrations[4], axes[4];
+            _mm_store_ps(penetrations, penetration.v);
+            _mm_store_ps(axes, axisIndex.v);
+            for (int lane = 0; lane < 4; lane++)
+                results[index + lane] = sat::makeResult(boxes[p[lane].first], boxes[p[lane].second], penetrations[lane], (int)axes[lane]);
+        }
+#endif
+        for (; index < count; index++)
+            results[index] = testOBBs(boxes[pairs[index].first], boxes[pairs[index].second]);
+    }
+
+}
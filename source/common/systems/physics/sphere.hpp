@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../../components/rigid-body.hpp"
+#include "../../ecs/entity.hpp"
+
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // A sphere in the world space
+    struct Sphere
+    {
+        glm::vec3 center = glm::vec3(0.0f);
+        float radius = 0.0f;
+
+        // Returns the sphere of the rigid body after transforming it by the given local to world matrix
+        // The sphere is centered on the bounding box of the body and its radius is scaled by the largest scale of the matrix
+        static Sphere fromRigidBody(const RigidBodyComponent *body, const glm::mat4 &localToWorld)
+        {
+            Sphere sphere;
+            sphere.center = localToWorld * glm::vec4((body->min_point + body->max_point) * 0.5f, 1.0f);
+            float scale = glm::max(glm::length(glm::vec3(localToWorld[0])), glm::max(glm::length(glm::vec3(localToWorld[1])), glm::length(glm::vec3(localToWorld[2]))));
+            sphere.radius = body->radius * scale;
+            return sphere;
+        }
+    };
+
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "aabb.hpp"
+#include "collision-matrix.hpp"
+#include "../../components/rigid-body.hpp"
+#include "../../components/movement.hpp"
+#include "../../ecs/world.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace our
+{
+
+    // The sweep and prune broadphase finds the pairs of rigid bodies whose AABBs overlap,
+    // so that the expensive narrowphase (SAT) only runs for these pairs instead of all the pairs in the world.
+    // The start and end points of the AABBs on the x axis are kept in a sorted list. Since the bodies move a little
+    // between two updates, the list is almost sorted, so it is re-sorted with an insertion sort in almost linear time.
+    // Then a single sweep over the list finds the overlapping pairs.
+    // Static bodies (walls, ground, goals and bodies marked as static) and sleeping bodies are resting: they are never paired with each other
+    // and their AABBs are not updated (the static ones are only computed when the list of bodies changes).
+    // If no body is awake, there is nothing to sort or sweep.
+    // The pairs whose tags do not interact in the collision matrix are rejected with a single AND before their boxes are compared.
+    class SweepAndPrune
+    {
+        struct Proxy
+        {
+            RigidBodyComponent *body;
+            MovementComponent *movement; // The movement of the body (if any), it tells if the body is sleeping
+            AABB box;
+            bool isStatic;
+            uint32_t category; // The bit of the tag of the body
+            uint32_t mask;     // The bits of the tags the body interacts with
+
+            bool isResting() const { return isStatic || (movement != nullptr && movement->sleeping); }
+        };
+
+        struct Endpoint
+        {
+            float value;
+            uint32_t proxy;
+            bool isMin;
+        };
+
+        std::vector<Proxy> proxies;
+        size_t entitiesVersion = 0; // The version of the world entities when the proxies were built
+        size_t rebuildCount = 0;    // The number of times the proxies were rebuilt
+        std::vector<Endpoint> endpoints; // The start and end points of the proxies on the x axis (sorted)
+        std::vector<uint32_t> activeResting, activeAwake; // The proxies whose interval contains the current sweep position
+        std::vector<std::pair<uint32_t, uint32_t>> overlaps; // The indices of the overlapping proxies
+
+        static bool lessThan(const Endpoint &first, const Endpoint &second)
+        {
+            // At equal values, start points come first so that touching boxes are paired
+            if (first.value != second.value)
+                return first.value < second.value;
+            return first.isMin && !second.isMin;
+        }
+
+        // Returns true if the proxies were built for exactly the given bodies (in the same order)
+        // The entities version is checked too since the memory of deleted bodies is reused by new ones
+        bool isSynced(const std::vector<RigidBodyComponent *> &bodies, size_t version) const
+        {
+            if (version != entitiesVersion || proxies.size() != bodies.size())
+                return false;
+            for (size_t index = 0; index < bodies.size(); index++)
+                if (proxies[index].body != bodies[index])
+                    return false;
+            return true;
+        }
+
+        // Rebuilds the proxies when bodies are added or removed
+        void rebuild(const std::vector<RigidBodyComponent *> &bodies, size_t version, const CollisionMatrix &matrix)
+        {
+            entitiesVersion = version;
+            rebuildCount++;
+            proxies.clear();
+            endpoints.clear();
+            for (RigidBodyComponent *body : bodies)
+            {
+                uint32_t index = (uint32_t)proxies.size();
+                proxies.push_back({body, body->getOwner()->getComponent<MovementComponent>(), AABB::fromRigidBody(body), body->isStaticBody(),
+                                   tagBit(body->tag), matrix.getMask(body->tag)});
+                endpoints.push_back({proxies.back().box.min.x, index, true});
+                endpoints.push_back({proxies.back().box.max.x, index, false});
+            }
+            std::sort(endpoints.begin(), endpoints.end(), lessThan);
+        }
+
+        static void insertionSort(std::vector<Endpoint> &list)
+        {
+            for (size_t index = 1; index < list.size(); index++)
+            {
+                Endpoint endpoint = list[index];
+                size_t position = index;
+                while (position > 0 && lessThan(endpoint, list[position - 1]))
+                {
+                    list[position] = list[position - 1];
+                    position--;
+                }
+                list[position] = endpoint;
+            }
+        }
+
+    public:
+        // Updates the AABBs of the awake bodies, re-sorts the endpoints and returns the overlapping pairs (see "getOverlaps")
+        // The masks of the bodies are read from the collision matrix when the proxies are rebuilt (see "invalidate")
+        const std::vector<std::pair<uint32_t, uint32_t>> &update(World *world, const CollisionMatrix &matrix)
+        {
+            const std::vector<RigidBodyComponent *> &bodies = world->getComponents<RigidBodyComponent>();
+            overlaps.clear();
+            if (!isSynced(bodies, world->getEntitiesVersion()))
+            {
+                rebuild(bodies, world->getEntitiesVersion(), matrix);
+            }
+            else
+            {
+                size_t awake = 0;
+                for (Proxy &proxy : proxies)
+                {
+                    if (proxy.isResting())
+                        continue;
+                    proxy.box = AABB::fromRigidBody(proxy.body);
+                    awake++;
+                }
+                // resting bodies never touch each other
+                if (awake == 0)
+                    return overlaps;
+                for (Endpoint &endpoint : endpoints)
+                {
+                    const AABB &box = proxies[endpoint.proxy].box;
+                    endpoint.value = endpoint.isMin ? box.min.x : box.max.x;
+                }
+                insertionSort(endpoints);
+            }
+
+            activeResting.clear();
+            activeAwake.clear();
+            for (const Endpoint &endpoint : endpoints)
+            {
+                const Proxy &proxy = proxies[endpoint.proxy];
+                bool resting = proxy.isResting();
+                std::vector<uint32_t> &active = resting ? activeResting : activeAwake;
+                if (!endpoint.isMin)
+                {
+                    active.erase(std::find(active.begin(), active.end(), endpoint.proxy));
+                    continue;
+                }
+                // A resting body is only tested against the awake bodies, an awake body is tested against both
+                auto testAgainst = [&](const std::vector<uint32_t> &others)
+                {
+                    for (uint32_t other : others)
+                        if ((proxy.mask & proxies[other].category) != 0 && proxy.box.overlaps(proxies[other].box))
+                            overlaps.push_back(std::minmax(other, endpoint.proxy));
+                };
+                testAgainst(activeAwake);
+                if (!resting)
+                    testAgainst(activeResting);
+                active.push_back(endpoint.proxy);
+            }
+
+            // The pairs are returned in the same order as a loop over all the pairs of bodies would visit them,
+            // so the collision responses are applied in the same order every frame
+            std::sort(overlaps.begin(), overlaps.end());
+            return overlaps;
+        }
+
+        // Forces the proxies to be rebuilt by the next update (e.g. after the collision matrix changed)
+        void invalidate() { proxies.clear(); }
+
+        // Returns the pairs found by the last update as indices of proxies (sorted, the smaller index first)
+        const std::vector<std::pair<uint32_t, uint32_t>> &getOverlaps() const { return overlaps; }
+
+        // The proxies are in the same order as the rigid bodies of the world
+        size_t getProxyCount() const { return proxies.size(); }
+        RigidBodyComponent *getBody(uint32_t proxy) const { return proxies[proxy].body; }
+
+        // Returns true if the proxy is static or sleeping (its AABB did not change in the last update)
+        bool isResting(uint32_t proxy) const { return proxies[proxy].isResting(); }
+
+        // Returns the number of times the proxies were rebuilt, anything cached per proxy must be rebuilt when it changes
+        size_t getRebuildCount() const { return rebuildCount; }
+    };
+
+}
@@ -0,0 +1,382 @@
+#pragma once
+
+#include "aabb.hpp"
+#include "sat.hpp"
+#include "obb.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace our
+{
+
+    // Returns the point of the triangle (a, b, c) closest to "point" (Ericson, Real-Time Collision Detection 5.1.5)
+    inline glm::vec3 closestPointOnTriangle(glm::vec3 point, glm::vec3 a, glm::vec3 b, glm::vec3 c)
+    {
+        glm::vec3 ab = b - a, ac = c - a, ap = point - a;
+        float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f)
+            return a;
+
+        glm::vec3 bp = point - b;
+        float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3)
+            return b;
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+            return a + ab * (d1 / (d1 - d3));
+
+        glm::vec3 cp = point - c;
+        float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6)
+            return c;
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+            return a + ac * (d2 / (d2 - d6));
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+            return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+        float denominator = 1.0f / (va + vb + vc);
+        return a + ab * (vb * denominator) + ac * (vc * denominator);
+    }
+
+    // Tests a sphere against a triangle, the normal points from the sphere to the triangle
+    inline CollisionResult testSphereTriangle(glm::vec3 center, float radius, glm::vec3 a, glm::vec3 b, glm::vec3 c)
+    {
+        CollisionResult result;
+        glm::vec3 separation = closestPointOnTriangle(center, a, b, c) - center;
+        float distanceSquared = glm::dot(separation, separation);
+        if (distanceSquared > radius * radius)
+            return result;
+
+        result.collided = true;
+        float distance = glm::sqrt(distanceSquared);
+        if (distance > 1e-6f)
+        {
+            result.normal = separation / distance;
+            result.penetration = radius - distance;
+            return result;
+        }
+        // The center is on the triangle, so the sphere is pushed out along the triangle normal (towards the side it came from is unknown)
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        result.normal = glm::length(normal) > 0.0f ? -glm::normalize(normal) : glm::vec3(0.0f, -1.0f, 0.0f);
+        result.penetration = radius;
+        return result;
+    }
+
+    // The separating axis test of a box against a triangle (Akenine-Moller) on the 13 candidate axes:
+    // the 3 box axes, the triangle normal and the 9 cross products of the box axes and the triangle edges
+    // The normal points from the box to the triangle
+    inline CollisionResult testOBBTriangle(const OBB &box, glm::vec3 a, glm::vec3 b, glm::vec3 c)
+    {
+        CollisionResult result;
+        glm::vec3 edges[3] = {b - a, c - b, a - c};
+        glm::vec3 axes[13];
+        int axisCount = 0;
+        for (int i = 0; i < 3; i++)
+            axes[axisCount++] = box.axes[i];
+        axes[axisCount++] = glm::cross(edges[0], edges[1]);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                axes[axisCount++] = glm::cross(box.axes[i], edges[j]);
+
+        float best = FLT_MAX;
+        glm::vec3 bestNormal(0.0f);
+        for (int index = 0; index < axisCount; index++)
+        {
+            float lengthSquared = glm::dot(axes[index], axes[index]);
+            if (lengthSquared < 1e-10f)
+                continue; // A degenerate axis (parallel edges) is already covered by the other axes
+            glm::vec3 axis = axes[index] / glm::sqrt(lengthSquared);
+
+            float center = glm::dot(box.center, axis);
+            float radius = box.halfExtents.x * glm::abs(glm::dot(box.axes[0], axis)) +
+                           box.halfExtents.y * glm::abs(glm::dot(box.axes[1], axis)) +
+                           box.halfExtents.z * glm::abs(glm::dot(box.axes[2], axis));
+            float pa = glm::dot(a, axis), pb = glm::dot(b, axis), pc = glm::dot(c, axis);
+            float triangleMin = std::min(pa, std::min(pb, pc)), triangleMax = std::max(pa, std::max(pb, pc));
+
+            // The box is pushed to the side of the triangle where it overlaps the least
+            float forward = center + radius - triangleMin, backward = triangleMax - (center - radius);
+            if (forward < 0.0f || backward < 0.0f)
+                return result;
+            float overlap = std::min(forward, backward);
+            if (overlap < best)
+            {
+                best = overlap;
+                bestNormal = forward < backward ? axis : -axis;
+            }
+        }
+
+        result.collided = true;
+        result.normal = bestNormal;
+        result.penetration = best;
+        return result;
+    }
+
+    // A static triangle mesh used as a collider (e.g. the goal posts and the edges of the field)
+    // It keeps a compact copy of the triangles on the CPU (the rendering mesh only keeps them on the GPU)
+    // and a bounding volume hierarchy over them, so the queries only test the triangles near the query shape.
+    // The hierarchy is built once with the surface area heuristic and stored as a flat array of nodes in depth first order:
+    // the left child of an inner node is the next node and the index of the right child is stored in the node.
+    // Everything is in the local space of the mesh.
+    class TriangleMesh
+    {
+        struct Node
+        {
+            AABB bounds;
+            uint32_t offset; // The first triangle of a leaf, or the right child of an inner node
+            uint32_t count;  // The number of triangles of a leaf (0 for inner nodes)
+        };
+
+        static constexpr uint32_t LEAF_SIZE = 4; // A node with this many triangles or less is not split
+        static constexpr int BIN_COUNT = 12;     // The number of candidate split planes per axis
+
+        std::vector<glm::vec3> vertices;
+        std::vector<uint32_t> indices; // 3 per triangle, the triangles are sorted in the order of the leaves
+        std::vector<Node> nodes;
+
+        AABB getTriangleBounds(uint32_t triangle) const
+        {
+            glm::vec3 a = vertices[indices[3 * triangle]], b = vertices[indices[3 * triangle + 1]], c = vertices[indices[3 * triangle + 2]];
+            return {glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c))};
+        }
+
+        // Builds the subtree of the triangles [first, first + count) of "order" and returns the index of its root
+        uint32_t build(std::vector<uint32_t> &order, const std::vector<AABB> &bounds, const std::vector<glm::vec3> &centroids, uint32_t first, uint32_t count)
+        {
+            uint32_t nodeIndex = (uint32_t)nodes.size();
+            nodes.push_back({});
+
+            AABB nodeBounds = bounds[order[first]], centroidBounds = {centroids[order[first]], centroids[order[first]]};
+            for (uint32_t index = first + 1; index < first + count; index++)
+            {
+                nodeBounds = nodeBounds.merged(bounds[order[index]]);
+                centroidBounds = centroidBounds.merged({centroids[order[index]], centroids[order[index]]});
+            }
+            nodes[nodeIndex].bounds = nodeBounds;
+
+            // The triangles are binned by their centroids along every axis and the split with the least cost is chosen:
+            // cost = area(left) * count(left) + area(right) * count(right)
+            int bestAxis = -1, bestSplit = 0;
+            float bestCost = nodeBounds.getPerimeter() * count; // The cost of keeping the node as a leaf
+            glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+            if (count > LEAF_SIZE)
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    if (extent[axis] <= 0.0f)
+                        continue;
+                    AABB binBounds[BIN_COUNT];
+                    uint32_t binCounts[BIN_COUNT] = {};
+                    for (uint32_t index = first; index < first + count; index++)
+                    {
+                        int bin = std::min(BIN_COUNT - 1, (int)((centroids[order[index]][axis] - centroidBounds.min[axis]) / extent[axis] * BIN_COUNT));
+                        binBounds[bin] = binCounts[bin]++ == 0 ? bounds[order[index]] : binBounds[bin].merged(bounds[order[index]]);
+                    }
+                    // Sweep from the right to get the cost of every right side, then from the left
+                    float rightCosts[BIN_COUNT];
+                    AABB accumulated;
+                    uint32_t accumulatedCount = 0;
+                    for (int bin = BIN_COUNT - 1; bin > 0; bin--)
+                    {
+                        if (binCounts[bin] > 0)
+                            accumulated = accumulatedCount == 0 ? binBounds[bin] : accumulated.merged(binBounds[bin]);
+                        accumulatedCount += binCounts[bin];
+                        rightCosts[bin] = accumulatedCount == 0 ? 0.0f : accumulated.getPerimeter() * accumulatedCount;
+                    }
+                    accumulatedCount = 0;
+                    for (int bin = 0; bin < BIN_COUNT - 1; bin++)
+                    {
+                        if (binCounts[bin] > 0)
+                            accumulated = accumulatedCount == 0 ? binBounds[bin] : accumulated.merged(binBounds[bin]);
+                        accumulatedCount += binCounts[bin];
+                        if (accumulatedCount == 0 || accumulatedCount == count)
+                            continue;
+                        float cost = accumulated.getPerimeter() * accumulatedCount + rightCosts[bin + 1];
+                        if (cost < bestCost)
+                        {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestSplit = bin;
+                        }
+                    }
+                }
+            }
+
+            if (bestAxis < 0)
+            {
+                nodes[nodeIndex].offset = first;
+                nodes[nodeIndex].count = count;
+                return nodeIndex;
+            }
+
+            auto middle = std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t triangle)
+                                         {
+                int bin = std::min(BIN_COUNT - 1, (int)((centroids[triangle][bestAxis] - centroidBounds.min[bestAxis]) / extent[bestAxis] * BIN_COUNT));
+                return bin <= bestSplit; });
+            uint32_t leftCount = (uint32_t)(middle - (order.begin() + first));
+
+            build(order, bounds, centroids, first, leftCount);
+            uint32_t right = build(order, bounds, centroids, first + leftCount, count - leftCount);
+            nodes[nodeIndex].offset = right;
+            nodes[nodeIndex].count = 0;
+            return nodeIndex;
+        }
+
+        // Calls "callback(triangle)" for every triangle in a leaf whose node passes "test(bounds)"
+        // The stack grows with the depth of the tree, it is kept per thread so that the queries do not allocate
+        // (a callback may start another traversal, it pushes on top of the nodes of this one)
+        template <typename Test, typename Callback>
+        void traverse(const Test &test, const Callback &callback) const
+        {
+            if (nodes.empty())
+                return;
+            thread_local std::vector<uint32_t> stack;
+            size_t bottom = stack.size();
+            stack.push_back(0);
+            while (stack.size() > bottom)
+            {
+                const Node &node = nodes[stack.back()];
+                stack.pop_back();
+                if (!test(node.bounds))
+                    continue;
+                if (node.count > 0)
+                {
+                    for (uint32_t triangle = node.offset; triangle < node.offset + node.count; triangle++)
+                        callback(triangle);
+                    continue;
+                }
+                uint32_t left = (uint32_t)(&node - nodes.data()) + 1;
+                stack.push_back(node.offset);
+                stack.push_back(left);
+            }
+        }
+
+    public:
+        // Copies the triangles "elements" (3 vertex indices per triangle) and builds the hierarchy
+        TriangleMesh(const std::vector<glm::vec3> &vertices, const std::vector<uint32_t> &elements) : vertices(vertices)
+        {
+            uint32_t triangleCount = (uint32_t)(elements.size() / 3);
+            if (triangleCount == 0)
+                return;
+
+            std::vector<uint32_t> order(triangleCount);
+            std::vector<AABB> bounds(triangleCount);
+            std::vector<glm::vec3> centroids(triangleCount);
+            indices = elements;
+            for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+            {
+                order[triangle] = triangle;
+                bounds[triangle] = getTriangleBounds(triangle);
+                centroids[triangle] = (bounds[triangle].min + bounds[triangle].max) * 0.5f;
+            }
+            nodes.reserve(2 * triangleCount / LEAF_SIZE + 1);
+            build(order, bounds, centroids, 0, triangleCount);
+
+            // The triangles are stored in the order of the leaves
+            for (uint32_t index = 0; index < triangleCount; index++)
+                for (int corner = 0; corner < 3; corner++)
+                    indices[3 * index + corner] = elements[3 * order[index] + corner];
+        }
+
+        size_t getTriangleCount() const { return indices.size() / 3; }
+        size_t getNodeCount() const { return nodes.size(); }
+
+        // Returns the bounds of the whole mesh
+        AABB getBounds() const { return nodes.empty() ? AABB{} : nodes[0].bounds; }
+
+        void getTriangle(uint32_t triangle, glm::vec3 &a, glm::vec3 &b, glm::vec3 &c) const
+        {
+            a = vertices[indices[3 * triangle]];
+            b = vertices[indices[3 * triangle + 1]];
+            c = vertices[indices[3 * triangle + 2]];
+        }
+
+        // Calls "callback(triangle)" for every triangle whose leaf overlaps the box
+        template <typename Callback>
+        void queryBox(const AABB &box, const Callback &callback) const
+        {
+            traverse([&](const AABB &bounds)
+                     { return bounds.overlaps(box); },
+                     callback);
+        }
+
+        // Finds the first triangle hit by the ray "origin + t * direction" with t in [0, maxT]
+        // Returns true if a triangle was hit and stores the parameter of the hit and the normal of the triangle (facing the ray)
+        bool raycast(glm::vec3 origin, glm::vec3 direction, float maxT, float &t, glm::vec3 &normal) const
+        {
+            glm::vec3 inverseDirection = 1.0f / direction;
+            bool found = false;
+            traverse([&](const AABB &bounds)
+                     { return bounds.intersectsRay(origin, inverseDirection, maxT); },
+                     [&](uint32_t triangle)
+                     {
+                         // Moller-Trumbore
+                         glm::vec3 a, b, c;
+                         getTriangle(triangle, a, b, c);
+                         glm::vec3 ab = b - a, ac = c - a;
+                         glm::vec3 p = glm::cross(direction, ac);
+                         float determinant = glm::dot(ab, p);
+                         if (glm::abs(determinant) < 1e-12f)
+                             return;
+                         float inverse = 1.0f / determinant;
+                         glm::vec3 offset = origin - a;
+                         float u = glm::dot(offset, p) * inverse;
+                         if (u < 0.0f || u > 1.0f)
+                             return;
+                         glm::vec3 q = glm::cross(offset, ab);
+                         float v = glm::dot(direction, q) * inverse;
+                         if (v < 0.0f || u + v > 1.0f)
+                             return;
+                         float hitT = glm::dot(ac, q) * inverse;
+                         if (hitT < 0.0f || hitT > maxT)
+                             return;
+                         maxT = hitT; // The nodes farther than the closest hit are skipped
+                         t = hitT;
+                         normal = glm::normalize(glm::cross(ab, ac));
+                         if (glm::dot(normal, direction) > 0.0f)
+                             normal = -normal;
+                         found = true;
+                     });
+            return found;
+        }
+
+        // Tests a sphere against the mesh and returns the deepest contact (the normal points from the sphere to the mesh)
+        CollisionResult testSphere(glm::vec3 center, float radius) const
+        {
+            CollisionResult deepest;
+            queryBox({center - radius, center + radius}, [&](uint32_t triangle)
+                     {
+                glm::vec3 a, b, c;
+                getTriangle(triangle, a, b, c);
+                CollisionResult result = testSphereTriangle(center, radius, a, b, c);
+                if (result.collided && (!deepest.collided || result.penetration > deepest.penetration))
+                    deepest = result; });
+            return deepest;
+        }
+
+        // Tests an oriented box against the mesh and returns the deepest contact (the normal points from the box to the mesh)
+        CollisionResult testOBB(const OBB &box) const
+        {
+            glm::vec3 extent = glm::abs(box.axes[0]) * box.halfExtents.x + glm::abs(box.axes[1]) * box.halfExtents.y + glm::abs(box.axes[2]) * box.halfExtents.z;
+            CollisionResult deepest;
+            queryBox({box.center - extent, box.center + extent}, [&](uint32_t triangle)
+                     {
+                glm::vec3 a, b, c;
+                getTriangle(triangle, a, b, c);
+                CollisionResult result = testOBBTriangle(box, a, b, c);
+                if (result.collided && (!deepest.collided || result.penetration > deepest.penetration))
+                    deepest = result; });
+            return deepest;
+        }
+    };
+
+}
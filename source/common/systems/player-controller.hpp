@@ -63,21 +63,13 @@ namespace our
         // This should be called every frame to update all entities containing a FreeCameraControllerComponent 
         void update(World* world, float deltaTime) {
             // First of all, we search for an entity containing Player Contoller
-            // As soon as we find one, we break
-            
-            PlayerController *controller = nullptr;
-            for(auto entity : world->getEntities()){
-                controller = entity->getComponent<PlayerController>();
-                if(controller) break;
-            }
-            
-
-            // If there is no entity with both a CameraComponent and a FreeCameraControllerComponent, we can do nothing so we return
-            if(!(controller)) return;
+            const auto& players = world->view<PlayerController, MovementComponent>();
 
+            // If there is no entity with both a PlayerController and a MovementComponent, we can do nothing so we return
+            if(players.empty()) return;
 
-            // Get the entity that we found via getOwner of camera (we could use controller->getOwner())
-            Entity* entity = controller->getOwner();
+            Entity* entity = players.front();
+            PlayerController *controller = entity->getComponent<PlayerController>();
             MovementComponent* movement = entity->getComponent<MovementComponent>();
 
 
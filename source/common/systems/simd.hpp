@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cmath>
+
+// SSE2 is part of every x86-64 CPU, so it is used without any extra compiler flag
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OUR_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace our
+{
+
+    // The operations used by the vectorized kernels (the separating axis test, the movement integration)
+    // A kernel is written once as a template on its number type: with "float" it processes one element at a time
+    // and with "Float4" it processes 4 elements together (one per lane)
+    namespace simd
+    {
+        // The scalar versions of the operations
+        inline float absolute(float value) { return std::fabs(value); }
+        inline float squareRoot(float value) { return std::sqrt(value); }
+        inline float maximum(float a, float b) { return a > b ? a : b; }
+        inline float minimum(float a, float b) { return a < b ? a : b; }
+        inline bool lessThan(float a, float b) { return a < b; }
+        inline float select(bool mask, float a, float b) { return mask ? a : b; }
+        inline void load(float &value, const float *source) { value = *source; }
+        inline void store(float *destination, float value) { *destination = value; }
+
+#ifdef OUR_USE_SSE
+        // 4 floats processed together, every lane holds the data of a different element
+        struct Float4
+        {
+            __m128 v;
+            Float4() = default;
+            Float4(__m128 v) : v(v) {}
+            Float4(float value) : v(_mm_set1_ps(value)) {}
+        };
+        inline Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+        inline Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+        inline Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+        inline Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+        inline Float4 absolute(Float4 value) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), value.v); }
+        inline Float4 squareRoot(Float4 value) { return _mm_sqrt_ps(value.v); }
+        inline Float4 maximum(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+        inline Float4 minimum(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+        inline Float4 lessThan(Float4 a, Float4 b) { return _mm_cmplt_ps(a.v, b.v); }
+        inline Float4 select(Float4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+        inline void load(Float4 &value, const float *source) { value = _mm_loadu_ps(source); }
+        inline void store(float *destination, Float4 value) { _mm_storeu_ps(destination, value.v); }
+#endif
+    }
+
+}
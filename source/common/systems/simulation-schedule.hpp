@@ -0,0 +1,80 @@
+#pragma once
+
+#include "system-scheduler.hpp"
+#include "player-controller.hpp"
+#include "collision-detector.hpp"
+#include "movement.hpp"
+#include "physics/physics-queries.hpp"
+#include "../components/rigid-body.hpp"
+#include "../components/ball-component.hpp"
+
+#include <functional>
+
+namespace our
+{
+
+    // The systems that advance the simulation of a level
+    struct SimulationSystems
+    {
+        CollisionSystem *collision;
+        PlayerControllerSystem *playerController;
+        MovementSystem *movement;
+        PhysicsQueries *physicsQueries;
+    };
+
+    // The flags set by the collision system for the events a level handles (nullptr if the level ignores the event)
+    // A frame may run several ticks, so the events stay set until the level handles and clears them
+    struct SimulationEvents
+    {
+        bool *goalScore = nullptr;
+        bool *bombExplodes = nullptr;
+        bool *ballSound = nullptr;
+    };
+
+    // Registers the simulation systems (run at a fixed time step) in the order in which they used to run one after the other
+    // The scheduler runs the systems that do not touch the same data in parallel
+    // "afterMovement" may add the systems of a level that should run right after the movement system
+    inline void scheduleSimulation(SystemScheduler &scheduler, SimulationSystems systems, SimulationEvents events,
+                                   const std::function<void(SystemScheduler &)> &afterMovement = nullptr)
+    {
+        scheduler.clear();
+        // The spatial queries see the bodies where they were at the end of the last tick
+        // They do not conflict with the collision system, so both run in the first stage
+        scheduler.addSystem("physics queries",
+                            SystemAccess().reading<RigidBodyComponent, Transform>().writingResource(systems.physicsQueries),
+                            [systems](World *world, float)
+                            { systems.physicsQueries->update(world); });
+        // All the collision responses and events of the tick come from a single pass over the contacts
+        SystemAccess collisionAccess = SystemAccess().reading<RigidBodyComponent, Transform>().writing<MovementComponent>().writingResource(systems.collision);
+        for (bool *event : {events.goalScore, events.bombExplodes, events.ballSound})
+            if (event)
+                collisionAccess.writingResource(event);
+        scheduler.addSystem("collision", collisionAccess,
+                            [systems, events](World *world, float deltaTime)
+                            {
+                                systems.collision->update(world, deltaTime);
+                                if (events.goalScore)
+                                    *events.goalScore |= systems.collision->checkForGoal();
+                                if (events.bombExplodes)
+                                    *events.bombExplodes |= systems.collision->checkForBombCollision();
+                                if (events.ballSound)
+                                    *events.ballSound |= systems.collision->checkForBallCollision();
+                            });
+        scheduler.addSystem("player controller",
+                            SystemAccess().reading<PlayerController>().writing<MovementComponent, Transform>().onMainThread(),
+                            [systems](World *world, float deltaTime)
+                            { systems.playerController->update(world, deltaTime); });
+        scheduler.addSystem("movement",
+                            SystemAccess().reading<BallComponent>().writing<MovementComponent, Transform>(),
+                            [systems](World *world, float deltaTime)
+                            { systems.movement->update(world, deltaTime); });
+        if (afterMovement)
+            afterMovement(scheduler);
+        // The fast bodies that moved through a wall or a goal in this tick are moved back to where they hit it
+        scheduler.addSystem("continuous collision",
+                            SystemAccess().reading<RigidBodyComponent>().writing<Transform>().writingResource(systems.collision).readingResource(systems.physicsQueries),
+                            [systems](World *world, float)
+                            { systems.collision->sweepContinuousBodies(world); });
+    }
+
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include "../ecs/world.hpp"
+#include "../ecs/transform.hpp"
+#include "../jobs/thread-pool.hpp"
+#include "transform.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace our
+{
+
+    // The access mask has one bit for each registered component type plus one bit for the entities transforms
+    typedef std::bitset<COMPONENT_TYPE_COUNT + 1> AccessMask;
+
+    // Returns the bit of T in the access mask (T is either a registered component type or Transform)
+    template <typename T>
+    constexpr size_t accessID()
+    {
+        if constexpr (std::is_same<T, Transform>::value)
+            return COMPONENT_TYPE_COUNT;
+        else
+            return componentTypeID<T>();
+    }
+
+    // Describes the data that a system reads and writes, so that the scheduler knows which systems can run at the same time
+    // Besides the component types, a system can declare the objects it shares with other systems (e.g. a system object
+    // that keeps intermediate results in its members) as resources
+    struct SystemAccess
+    {
+        AccessMask reads, writes;
+        std::vector<const void *> readResources, writeResources;
+        bool mainThread = false; // If true, the system runs on the thread that called "run" (required for GLFW and OpenGL calls)
+
+        // The world transforms are refreshed at the sync points, so reading them does not write to their caches
+        template <typename... Ts>
+        SystemAccess &reading()
+        {
+            (reads.set(accessID<Ts>()), ...);
+            return *this;
+        }
+
+        template <typename... Ts>
+        SystemAccess &writing()
+        {
+            (writes.set(accessID<Ts>()), ...);
+            return *this;
+        }
+
+        SystemAccess &readingResource(const void *resource)
+        {
+            readResources.push_back(resource);
+            return *this;
+        }
+
+        SystemAccess &writingResource(const void *resource)
+        {
+            writeResources.push_back(resource);
+            return *this;
+        }
+
+        SystemAccess &onMainThread()
+        {
+            mainThread = true;
+            return *this;
+        }
+
+        // Returns true if the two systems touch the same data and at least one of them writes it
+        bool conflictsWith(const SystemAccess &other) const
+        {
+            if ((writes & (other.reads | other.writes)).any() || (reads & other.writes).any())
+                return true;
+            auto shares = [](const std::vector<const void *> &first, const std::vector<const void *> &second)
+            {
+                for (const void *resource : first)
+                    if (std::find(second.begin(), second.end(), resource) != second.end())
+                        return true;
+                return false;
+            };
+            return shares(writeResources, other.readResources) || shares(writeResources, other.writeResources) ||
+                   shares(readResources, other.writeResources);
+        }
+    };
+
+    // The system scheduler runs the systems of a state every frame using the thread pool.
+    // Every system declares the data it reads and writes (see "SystemAccess"). A system depends on every system
+    // added before it that conflicts with it, so the result is the same as running the systems one after the other
+    // in the order they were added. The systems are grouped in stages where every system only depends on systems
+    // of earlier stages, and the systems of a stage run in parallel.
+    // After every stage (a sync point), the structural changes recorded in the world command buffer are applied,
+    // and before a stage that uses the transforms, the world transforms that changed are refreshed.
+    // NOTE: the lists returned by "World::view" are built on the first call, so they should not be requested for the first time in parallel
+    class SystemScheduler
+    {
+    public:
+        typedef std::function<void(World *, float)> SystemFunction;
+
+    private:
+        struct System
+        {
+            std::string name;
+            SystemAccess access;
+            SystemFunction function;
+            size_t stage;
+        };
+
+        std::vector<System> systems;
+        std::vector<std::vector<size_t>> stages; // The indices of the systems in every stage
+        bool stagesDirty = true;
+        TransformSystem transformSystem; // Refreshes the world transforms at the sync points
+
+        // Returns true if a system of the stage reads or writes the transforms
+        bool usesTransforms(const std::vector<size_t> &stage, bool writing) const
+        {
+            for (size_t index : stage)
+            {
+                const SystemAccess &access = systems[index].access;
+                if (access.writes.test(accessID<Transform>()) || (!writing && access.reads.test(accessID<Transform>())))
+                    return true;
+            }
+            return false;
+        }
+
+        void buildStages()
+        {
+            stages.clear();
+            for (size_t index = 0; index < systems.size(); index++)
+            {
+                size_t stage = 0;
+                for (size_t previous = 0; previous < index; previous++)
+                    if (systems[index].access.conflictsWith(systems[previous].access))
+                        stage = std::max(stage, systems[previous].stage + 1);
+                systems[index].stage = stage;
+                if (stages.size() <= stage)
+                    stages.resize(stage + 1);
+                stages[stage].push_back(index);
+            }
+            stagesDirty = false;
+        }
+
+    public:
+        // Adds a system to the schedule, it will run after all the conflicting systems that were added before it
+        void addSystem(const std::string &name, const SystemAccess &access, SystemFunction function)
+        {
+            systems.push_back({name, access, std::move(function), 0});
+            stagesDirty = true;
+        }
+
+        // Removes all the systems
+        void clear()
+        {
+            systems.clear();
+            stages.clear();
+            stagesDirty = true;
+        }
+
+        // Returns the number of stages, the systems of a stage run in parallel
+        size_t getStageCount()
+        {
+            if (stagesDirty)
+                buildStages();
+            return stages.size();
+        }
+
+        // Runs all the systems on the world once
+        void run(World *world, float deltaTime)
+        {
+            if (stagesDirty)
+                buildStages();
+            ThreadPool *pool = ThreadPool::getInstance();
+            bool transformsChanged = true; // The transforms may have changed since the last run (e.g. by a reset)
+            for (const auto &stage : stages)
+            {
+                // The caches are refreshed here so that the systems of the stage only read them
+                if (transformsChanged && usesTransforms(stage, false))
+                {
+                    transformSystem.refreshWorldTransforms(world);
+                    transformsChanged = false;
+                }
+
+                TaskGroup group;
+                // The systems that may run on any thread are submitted first so that the workers start on them
+                // while the calling thread runs the main thread systems
+                for (size_t index : stage)
+                {
+                    System &system = systems[index];
+                    if (system.access.mainThread)
+                        continue;
+                    if (stage.size() == 1)
+                        system.function(world, deltaTime);
+                    else
+                        pool->submit(group, [&system, world, deltaTime]()
+                                     { system.function(world, deltaTime); });
+                }
+                for (size_t index : stage)
+                    if (systems[index].access.mainThread)
+                        systems[index].function(world, deltaTime);
+                pool->wait(group);
+
+                transformsChanged |= usesTransforms(stage, true);
+
+                // Sync point: apply the structural changes recorded by the systems of this stage
+                CommandBuffer &commands = world->getCommandBuffer();
+                if (!commands.empty())
+                {
+                    commands.flush(world);
+                    transformsChanged = true;
+                }
+            }
+        }
+    };
+
+}
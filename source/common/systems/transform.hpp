@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../ecs/world.hpp"
+#include "../jobs/thread-pool.hpp"
+
+#include <vector>
+#include <algorithm>
+
+namespace our
+{
+
+    // The transform system refreshes the cached world transform of every entity once per frame.
+    // Entities are visited in parent-before-child order so each entity can build its world matrix
+    // from its parent's cached matrix without walking up the hierarchy.
+    // Entities whose local transform (and ancestors) did not change since the last frame are skipped,
+    // so the static geometry of the field is never recomputed.
+    // The entities of the same depth only read the caches of their parents, so every depth level is updated in parallel.
+    // It also computes the matrices used for rendering by interpolating between the last two simulation steps.
+    class TransformSystem
+    {
+        // The minimum number of entities updated by a single task
+        static constexpr size_t GRAIN_SIZE = 128;
+
+        std::vector<Entity *> orderedEntities; // The entities of the world sorted by their depth in the hierarchy
+        std::vector<size_t> depthOffsets;      // The index in "orderedEntities" at which every depth level starts (plus the end)
+        size_t orderedEntitiesVersion = 0;     // The world entities version for which "orderedEntities" was built
+        World *orderedWorld = nullptr;         // The world for which "orderedEntities" was built
+
+        static int getDepth(const Entity *entity)
+        {
+            int depth = 0;
+            for (const Entity *node = entity->parent; node != nullptr; node = node->parent)
+                depth++;
+            return depth;
+        }
+
+        void sortEntities(World *world)
+        {
+            const auto &entities = world->getEntities();
+            std::vector<std::pair<int, Entity *>> entitiesWithDepth;
+            entitiesWithDepth.reserve(entities.size());
+            for (Entity *entity : entities)
+                entitiesWithDepth.push_back({getDepth(entity), entity});
+            std::stable_sort(entitiesWithDepth.begin(), entitiesWithDepth.end(), [](const auto &first, const auto &second)
+                             { return first.first < second.first; });
+
+            orderedEntities.clear();
+            depthOffsets.clear();
+            for (auto &[depth, entity] : entitiesWithDepth)
+            {
+                while ((int)depthOffsets.size() <= depth)
+                    depthOffsets.push_back(orderedEntities.size());
+                orderedEntities.push_back(entity);
+            }
+            depthOffsets.push_back(orderedEntities.size());
+            orderedEntitiesVersion = world->getEntitiesVersion();
+            orderedWorld = world;
+        }
+
+    public:
+        // This should be called before every simulation step to remember the transforms of the previous step
+        void savePreviousTransforms(World *world)
+        {
+            for (Entity *entity : world->getEntities())
+                entity->savePreviousTransform();
+        }
+
+        // Calls "function(entity)" for every entity, the parents are visited before their children
+        // and the entities of the same depth are visited in parallel
+        template <typename Function>
+        void forEachInHierarchyOrder(World *world, const Function &function)
+        {
+            if (orderedWorld != world || orderedEntitiesVersion != world->getEntitiesVersion())
+                sortEntities(world);
+            ThreadPool *pool = ThreadPool::getInstance();
+            for (size_t depth = 0; depth + 1 < depthOffsets.size(); depth++)
+            {
+                size_t begin = depthOffsets[depth];
+                pool->parallelFor(depthOffsets[depth + 1] - begin, GRAIN_SIZE, [this, begin, &function](size_t first, size_t last)
+                                  {
+                    for (size_t index = begin + first; index < begin + last; index++)
+                        function(orderedEntities[index]); });
+            }
+        }
+
+        // This should be called every frame after the simulation systems and before rendering
+        // The interpolation alpha is how far the frame is between the previous and the current simulation steps
+        void update(World *world, float interpolationAlpha = 1.0f)
+        {
+            forEachInHierarchyOrder(world, [interpolationAlpha](Entity *entity)
+                                    {
+                entity->updateWorldTransform();
+                entity->updateRenderTransform(interpolationAlpha); });
+        }
+
+        // Brings the world matrices and their inverse transposes up to date without touching the render matrices
+        // After this call, reading the world transform of an entity does not write to its cache until the entity moves again,
+        // so the system scheduler calls it at the sync points to let the systems read the transforms in parallel
+        void refreshWorldTransforms(World *world)
+        {
+            forEachInHierarchyOrder(world, [](Entity *entity)
+                                    {
+                entity->updateWorldTransform();
+                entity->getLocalToWorldInverseTranspose(); });
+        }
+    };
+
+}
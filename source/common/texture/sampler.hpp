@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../gl-state-tracker.hpp"
+
 #include <glad/gl.h>
 #include <json/json.hpp>
 #include <glm/vec4.hpp>
@@ -25,6 +27,7 @@ namespace our
         ~Sampler()
         {
             // TODO: (Req 6) Complete this function
+            GLStateTracker::getInstance()->forgetSampler(name);
             glDeleteSamplers(1, &name);
         }
 
@@ -32,14 +35,14 @@ namespace our
         void bind(GLuint textureUnit) const
         {
             // TODO: (Req 6) Complete this function
-            glBindSampler(textureUnit, name);
+            GLStateTracker::getInstance()->bindSampler(textureUnit, name);
         }
 
         // This static method ensures that no sampler is bound to the given texture unit
         static void unbind(GLuint textureUnit)
         {
             // TODO: (Req 6) Complete this function
-            glBindSampler(textureUnit, 0);
+            GLStateTracker::getInstance()->bindSampler(textureUnit, 0);
         }
 
         // This function sets a sampler paramter where the value is of type "GLint"
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../gl-state-tracker.hpp"
+
 #include <glad/gl.h>
 
 namespace our
@@ -23,6 +25,7 @@ namespace our
         ~Texture2D()
         {
             // TODO: (Req 5) Complete this function
+            GLStateTracker::getInstance()->forgetTexture(name);
             glDeleteTextures(1, &name);
         }
 
@@ -36,14 +39,14 @@ namespace our
         void bind() const
         {
             // TODO: (Req 5) Complete this function
-            glBindTexture(GL_TEXTURE_2D, name);
+            GLStateTracker::getInstance()->bindTexture2D(name);
         }
 
         // This static method ensures that no texture is bound to GL_TEXTURE_2D
         static void unbind()
         {
             // TODO: (Req 5) Complete this function
-            glBindTexture(GL_TEXTURE_2D, 0);
+            GLStateTracker::getInstance()->bindTexture2D(0);
         }
 
         Texture2D(const Texture2D &) = delete;
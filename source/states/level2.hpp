@@ -8,6 +8,10 @@
 #include <systems/player-controller.hpp>
 #include <systems/collision-detector.hpp>
 #include <systems/movement.hpp>
+#include <systems/transform.hpp>
+#include <systems/system-scheduler.hpp>
+#include <systems/simulation-schedule.hpp>
+#include <systems/physics/physics-queries.hpp>
 #include <asset-loader.hpp>
 #include "./menu-state.hpp"
 
@@ -29,7 +33,11 @@ class Level2state : public our::State
     our::FreeCameraControllerSystem cameraController;
     our::PlayerControllerSystem playerController;
     our::MovementSystem movementSystem;
+    our::TransformSystem transformSystem;
     our::CollisionSystem collisionSystem;
+    our::PhysicsQueries physicsQueries;
+    our::SystemScheduler scheduler;
+    our::WorldSnapshot initialState; // The state of the world right after loading, restored after every goal or timeout
     bool bombExplodes = false;
     bool goalScore = false;
 
@@ -92,6 +100,8 @@ class Level2state : public our::State
         previousTime = time(NULL);
         countDownState = true;
         timeUp = false;
+        bombExplodes = false;
+        goalScore = false;
         countDownTime = 5;
         lives = 3;
         goals = 0;
@@ -109,6 +119,9 @@ class Level2state : public our::State
         {
             world.deserialize(config["world"]);
         }
+        initialState = world.snapshot();
+        world.setPhysicsQueries(&physicsQueries);
+        physicsQueries.update(&world);
 
         // TODO: remove this if not used
         // world.focusCamera();
@@ -116,6 +129,8 @@ class Level2state : public our::State
         // We initialize the camera controller system since it needs a pointer to the app
         cameraController.enter(getApp());
         playerController.enter(getApp());
+        // The simulation systems run at a fixed time step (see onFixedUpdate)
+        our::scheduleSimulation(scheduler, {&collisionSystem, &playerController, &movementSystem, &physicsQueries}, {&goalScore, &bombExplodes, &ballSound});
         // Then we initialize the renderer
         auto size = getApp()->getFrameBufferSize();
         renderer.initialize(size, config["renderer"]);
@@ -159,26 +174,8 @@ class Level2state : public our::State
 
     void handleReset()
     {
-        unordered_set<our::Entity *> entities = world.getEntities();
-        for (our::Entity *entity : entities)
-        {
-            entity->localTransform.position = entity->localTransform.initialPositionNew;
-            entity->localTransform.rotation = entity->localTransform.initialRotationNew;
-            entity->localTransform.scale = entity->localTransform.initialScaleNew;
-        }
-
-        vector<our::MovementComponent *> movements;
-        for (our::Entity *entity : entities)
-        {
-            our::MovementComponent *movement = entity->getComponent<our::MovementComponent>();
-            if (movement == nullptr)
-                continue;
-            movements.push_back(movement);
-        }
-        for (unsigned int i = 0; i < movements.size(); i++)
-        {
-            movements[i]->current_velocity = 0;
-        }
+        world.restore(initialState);
+        collisionSystem.reset();
     }
     void handleCountDown()
     {
@@ -207,7 +204,7 @@ class Level2state : public our::State
 
     void timerDraw(float deltaTime)
     {
-        glDisable(GL_BLEND);
+        our::GLStateTracker::getInstance()->setEnabled(GL_BLEND, false);
         glm::ivec2 size = getApp()->getFrameBufferSize();
         glViewport(0, 0, size.x, size.y);
 
@@ -238,7 +235,6 @@ class Level2state : public our::State
         seconds = level_seconds;
         minutes = level_minutes;
         soundSystem->playSound("sui");
-        unordered_set<our::Entity *> entities = world.getEntities();
         handleReset();
     }
 
@@ -254,7 +250,7 @@ class Level2state : public our::State
         vector<our::MovementComponent *> movementBodies;
         vector<our::PlayerController *> players;
 
-        for (our::Entity *entity : world.getEntities())
+        for (our::Entity *entity : world.view<our::RigidBodyComponent, our::MovementComponent>())
         {
             our::RigidBodyComponent *rigidBody = entity->getComponent<our::RigidBodyComponent>();
             our::MovementComponent *movement = entity->getComponent<our::MovementComponent>();
@@ -277,6 +273,21 @@ class Level2state : public our::State
             }
         }
     }
+
+    // The simulation is advanced by fixed time steps independent of the frame rate
+    void onFixedUpdate(double fixedDeltaTime) override
+    {
+        if (countDownState)
+            return;
+        transformSystem.savePreviousTransforms(&world);
+        scheduler.run(&world, (float)fixedDeltaTime);
+        if (ballSound)
+        {
+            soundSystem->playSound("ball");
+            ballSound = false;
+        }
+    }
+
     void onDraw(double deltaTime) override
     {
 
@@ -285,22 +296,11 @@ class Level2state : public our::State
         handleTimer();
         printLivesGoals();
 
+        // The camera controller reads the mouse movement of this frame so it runs every frame
         if (!countDownState)
-        {
-            collisionSystem.checkForCollisions(&world);
-            bombExplodes = collisionSystem.checkForBombCollision(&world);
-            goalScore = collisionSystem.checkForGoal(&world);
-            playerController.update(&world, (float)deltaTime);
-            movementSystem.update(&world, (float)deltaTime);
             cameraController.update(&world, (float)deltaTime);
-            ballSound = collisionSystem.checkForBallCollision(&world);
-            if (ballSound)
-            {
-                soundSystem->playSound("ball");
-                ballSound = false;
-            }
-        }
 
+        transformSystem.update(&world, getApp()->getInterpolationAlpha());
         renderer.render(&world);
 
         auto &keyboard = getApp()->getKeyboard();
@@ -8,6 +8,10 @@
 #include <systems/player-controller.hpp>
 #include <systems/collision-detector.hpp>
 #include <systems/movement.hpp>
+#include <systems/transform.hpp>
+#include <systems/system-scheduler.hpp>
+#include <systems/simulation-schedule.hpp>
+#include <systems/physics/physics-queries.hpp>
 #include <asset-loader.hpp>
 #include "./menu-state.hpp"
 
@@ -30,7 +34,11 @@ class Level4state : public our::State
     our::FreeCameraControllerSystem cameraController;
     our::PlayerControllerSystem playerController;
     our::MovementSystem movementSystem;
+    our::TransformSystem transformSystem;
     our::CollisionSystem collisionSystem;
+    our::PhysicsQueries physicsQueries;
+    our::SystemScheduler scheduler;
+    our::WorldSnapshot initialState; // The state of the world right after loading, restored after every goal or timeout
     bool goalScore = false;
     int delayTimeBeforeAnotherShot = delay_shot_time;
     bool timeUp = false;
@@ -95,6 +103,7 @@ class Level4state : public our::State
         previousTime = time(NULL);
         countDownState = true;
         timeUp = false;
+        goalScore = false;
         countDownTime = 5;
         goals = 0;
         delayTimeBeforeAnotherShot = delay_shot_time;
@@ -112,6 +121,9 @@ class Level4state : public our::State
         {
             world.deserialize(config["world"]);
         }
+        initialState = world.snapshot();
+        world.setPhysicsQueries(&physicsQueries);
+        physicsQueries.update(&world);
 
         // TODO: remove this if not used
         // world.focusCamera();
@@ -119,6 +131,8 @@ class Level4state : public our::State
         // We initialize the camera controller system since it needs a pointer to the app
         cameraController.enter(getApp());
         playerController.enter(getApp());
+        // The simulation systems run at a fixed time step (see onFixedUpdate)
+        our::scheduleSimulation(scheduler, {&collisionSystem, &playerController, &movementSystem, &physicsQueries}, {&goalScore, nullptr, &ballSound});
         // Then we initialize the renderer
         auto size = getApp()->getFrameBufferSize();
         renderer.initialize(size, config["renderer"]);
@@ -162,27 +176,10 @@ class Level4state : public our::State
 
     void handleReset()
     {
-        unordered_set<our::Entity *> entities = world.getEntities();
-        for (our::Entity *entity : entities)
-        {
-            entity->localTransform.position = entity->localTransform.initialPositionNew;
-            entity->localTransform.rotation = entity->localTransform.initialRotationNew;
-            entity->localTransform.scale = entity->localTransform.initialScaleNew;
-        }
-
-        vector<our::MovementComponent *> movements;
-        for (our::Entity *entity : entities)
-        {
-            our::MovementComponent *movement = entity->getComponent<our::MovementComponent>();
-            if (movement == nullptr)
-                continue;
-            movements.push_back(movement);
-        }
-        for (unsigned int i = 0; i < movements.size(); i++)
-        {
-            movements[i]->current_velocity = 0;
-            movements[i]->targetPointInWorldSpace = glm::vec3(30, 1, -11.7);
-        }
+        world.restore(initialState);
+        collisionSystem.reset();
+        for (our::MovementComponent *movement : world.getComponents<our::MovementComponent>())
+            movement->targetPointInWorldSpace = glm::vec3(30, 1, -11.7);
     }
     void handleCountDown()
     {
@@ -202,7 +199,7 @@ class Level4state : public our::State
         vector<our::MovementComponent *> movementBodies;
         vector<our::PlayerController *> players;
 
-        for (our::Entity *entity : world.getEntities())
+        for (our::Entity *entity : world.view<our::RigidBodyComponent, our::MovementComponent>())
         {
             our::RigidBodyComponent *rigidBody = entity->getComponent<our::RigidBodyComponent>();
             our::MovementComponent *movement = entity->getComponent<our::MovementComponent>();
@@ -243,7 +240,7 @@ class Level4state : public our::State
         vector<our::RigidBodyComponent *> rigidBodies;
         vector<our::MovementComponent *> movementBodies;
 
-        for (our::Entity *entity : world.getEntities())
+        for (our::Entity *entity : world.view<our::RigidBodyComponent, our::MovementComponent>())
         {
             our::RigidBodyComponent *rigidBody = entity->getComponent<our::RigidBodyComponent>();
             our::MovementComponent *movement = entity->getComponent<our::MovementComponent>();
@@ -294,7 +291,7 @@ class Level4state : public our::State
 
     void timerDraw(float deltaTime)
     {
-        glDisable(GL_BLEND);
+        our::GLStateTracker::getInstance()->setEnabled(GL_BLEND, false);
         glm::ivec2 size = getApp()->getFrameBufferSize();
         glViewport(0, 0, size.x, size.y);
 
@@ -313,7 +310,6 @@ class Level4state : public our::State
         goals++;
         goalScore = false;
         soundSystem->playSound("WhataSave");
-        unordered_set<our::Entity *> entities = world.getEntities();
         handleReset();
     }
 
@@ -328,7 +324,7 @@ class Level4state : public our::State
         vector<our::MovementComponent *> movementBodies;
         vector<our::PlayerController *> players;
 
-        for (our::Entity *entity : world.getEntities())
+        for (our::Entity *entity : world.view<our::RigidBodyComponent, our::MovementComponent>())
         {
             our::RigidBodyComponent *rigidBody = entity->getComponent<our::RigidBodyComponent>();
             our::MovementComponent *movement = entity->getComponent<our::MovementComponent>();
@@ -351,6 +347,21 @@ class Level4state : public our::State
             }
         }
     }
+
+    // The simulation is advanced by fixed time steps independent of the frame rate
+    void onFixedUpdate(double fixedDeltaTime) override
+    {
+        if (countDownState)
+            return;
+        transformSystem.savePreviousTransforms(&world);
+        scheduler.run(&world, (float)fixedDeltaTime);
+        if (ballSound)
+        {
+            soundSystem->playSound("ball");
+            ballSound = false;
+        }
+    }
+
     void onDraw(double deltaTime) override
     {
 
@@ -359,21 +370,11 @@ class Level4state : public our::State
         handleTimer();
         printGoals();
 
+        // The camera controller reads the mouse movement of this frame so it runs every frame
         if (!countDownState)
-        {
-            collisionSystem.checkForCollisions(&world);
-            goalScore = collisionSystem.checkForGoal(&world);
-            playerController.update(&world, (float)deltaTime);
-            movementSystem.update(&world, (float)deltaTime);
             cameraController.update(&world, (float)deltaTime);
-            ballSound = collisionSystem.checkForBallCollision(&world);
-            if (ballSound)
-            {
-                soundSystem->playSound("ball");
-                ballSound = false;
-            }
-        }
 
+        transformSystem.update(&world, getApp()->getInterpolationAlpha());
         renderer.render(&world);
 
         auto &keyboard = getApp()->getKeyboard();
@@ -83,8 +83,8 @@ class PipelineTestState : public our::State
     {
         // We make sure the color and depth masks are true (just in case the pipeline set any of them to false)
         // to make sure that glClear works correctly
-        glColorMask(true, true, true, true);
-        glDepthMask(true);
+        our::GLStateTracker::getInstance()->setColorMask(glm::bvec4(true));
+        our::GLStateTracker::getInstance()->setDepthMask(true);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         shader->use();
         // Before drawing, we setup the pipeline state